@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Bump allocator over a fixed buffer. Allocation is a pointer increment,
+/// freeing is rolling back to a mark, so the cost never depends on what was
+/// allocated before. Blocks are aligned to ARENA_ALIGN bytes.
+///
+///   ARENA_SCOPE(&scratch_arena);   // everything allocated below is
+///   ECPointJ* jac = ARENA_NEW(&scratch_arena, ECPointJ, 16);
+///                                  // released at the end of the block
+typedef struct {
+  uint8_t* base;
+  uint32_t capacity;
+  uint32_t used;
+  uint32_t peak;     ///< highest used since arena_init
+} arena_t;
+
+#define ARENA_ALIGN 8
+
+/// A static arena of bytes capacity and its storage, usable without
+/// arena_init
+#define ARENA_DEFINE(name, bytes)                                              \
+  static uint64_t name##_storage[((bytes) + ARENA_ALIGN - 1) / ARENA_ALIGN];   \
+  arena_t name = {(uint8_t*)name##_storage, sizeof(name##_storage), 0, 0}
+
+/// storage must be aligned to ARENA_ALIGN
+void arena_init(arena_t* arena, void* storage, uint32_t capacity);
+
+/// size bytes, or NULL when the arena is full
+void* arena_alloc(arena_t* arena, uint32_t size);
+
+/// Current position, pass it to arena_reset to free what was allocated since
+uint32_t arena_mark(const arena_t* arena);
+
+void arena_reset(arena_t* arena, uint32_t mark);
+
+/// count elements of type, uninitialized
+#define ARENA_NEW(arena, type, count) \
+  ((type*)arena_alloc((arena), (uint32_t)(sizeof(type) * (count))))
+
+typedef struct {
+  arena_t* arena;
+  uint32_t mark;
+} arena_scope_t;
+
+static inline void arena_scope_end(arena_scope_t* scope) {
+  arena_reset(scope->arena, scope->mark);
+}
+
+/// Frees everything allocated from arena after this line when the enclosing
+/// block exits, one per block
+#define ARENA_SCOPE(a)                                                         \
+  arena_scope_t arena_scope __attribute__((cleanup(arena_scope_end))) =        \
+      {(a), arena_mark(a)}
+
+/// Scratch shared by the curve code in old/ for tables and batch
+/// inversions, sized at compile time. The largest user is the comb table
+/// built by ec_comb_init.
+#ifndef SCRATCH_ARENA_SIZE
+#define SCRATCH_ARENA_SIZE 4096
+#endif
+
+extern arena_t scratch_arena;
+
+#ifdef __cplusplus
+}
+#endif
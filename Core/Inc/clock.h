@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+/// System clock profiles. Each one sets the PLL, the flash wait states (0 up
+/// to 30 MHz, 1 up to 64, 2 up to 90, 3 up to 100 at 3.3 V) and an APB1
+/// prescaler keeping PCLK1 within its 50 MHz limit. The PLL input is always
+/// 2 MHz, HSI / 8 or the 8 MHz HSE crystal / 4.
+
+typedef enum {
+  CLOCK_HSI16,   ///< HSI directly, PLL off, the reset configuration
+  CLOCK_HSI48,
+  CLOCK_HSI84,
+  CLOCK_HSI100,
+  CLOCK_HSE48,
+  CLOCK_HSE84,
+  CLOCK_HSE100,
+  CLOCK_PROFILE_COUNT,
+} clock_profile_t;
+
+/// Profile applied at startup, set by -DCLOCK_PROFILE in CMake
+#ifndef CLOCK_PROFILE
+#define CLOCK_PROFILE CLOCK_HSI16
+#endif
+
+/// Short name of a profile ("hsi16", "hse100", ...), NULL if out of range
+const char* clock_name(clock_profile_t profile);
+
+/// Switch to a profile, going through the HSI so the PLL can be
+/// reprogrammed. SystemCoreClock and the SysTick follow, peripherals clocked
+/// by the APB buses (the UART baud rate) must be reconfigured by the caller.
+/// Returns 0 if the oscillator or PLL failed to start, running from the HSI.
+int clock_apply(clock_profile_t profile);
+
+/// The profile currently running
+clock_profile_t clock_current(void);
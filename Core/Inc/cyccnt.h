@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+#if SIM_BUILD
+#include "sim.h"
+#endif
+
+/// Enable the DWT cycle counter, needed once after reset before
+/// cyccnt_read returns anything meaningful.
+static inline void cyccnt_init(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/// Current core cycle count, wraps every 2^32 cycles (~268 s at 16 MHz)
+static inline uint32_t cyccnt_read(void) {
+#if SIM_BUILD
+  return (uint32_t)sim_counter();
+#else
+  return DWT->CYCCNT;
+#endif
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+
+/// Commands exercising the 256-bit ECC code in old/, kept in their own
+/// translation unit so its types don't clash with the toy curve in main.c
+
+#define ECC_CMD_SECRET_BYTES 32
+#define ECC_CMD_SCALAR_BYTES 32
+#define ECC_CMD_POINT_BYTES 65  ///< SEC1 uncompressed
+
+typedef struct {
+  uint32_t keygen_cycles;   ///< cycles for one key generation
+  uint32_t exchange_cycles; ///< cycles for one ecdh_shared_secret
+  uint8_t secret[ECC_CMD_SECRET_BYTES];
+  int ok;                   ///< both sides derived the same secret
+} ecdh_bench_t;
+
+typedef enum {
+  ECC_CMD_P256,
+  ECC_CMD_X25519,
+} ecc_cmd_kex_t;
+
+/// Run a full key exchange between two fresh key pairs, timing the second
+/// party's shared secret computation with the DWT cycle counter.
+/// LD6 is held high during the timed exchange to trigger the scope.
+void ecc_cmd_ecdh(ecdh_bench_t* result, ecc_cmd_kex_t curve);
+
+typedef struct {
+  uint32_t cycles;          ///< cycles for ecdsa_sign, hashing excluded
+  uint8_t r[ECC_CMD_SCALAR_BYTES];
+  uint8_t s[ECC_CMD_SCALAR_BYTES];
+  int ok;
+} ecdsa_sign_bench_t;
+
+typedef struct {
+  uint32_t cycles;          ///< cycles for ecdsa_verify, hashing excluded
+  int ok;                   ///< the signature is valid
+} ecdsa_verify_bench_t;
+
+/// The device signing key is generated on first use and kept until reset,
+/// this returns its public half
+void ecc_cmd_pubkey(uint8_t* point);
+
+/// Sign SHA-256(msg) with the device key, LD6 is high during the signature
+void ecc_cmd_sign(ecdsa_sign_bench_t* result, const uint8_t* msg, uint32_t len);
+
+/// Verify (r, s) on SHA-256(msg) against the device key, LD6 is high during
+/// the verification
+void ecc_cmd_verify(ecdsa_verify_bench_t* result, const uint8_t* r, const uint8_t* s,
+                    const uint8_t* msg, uint32_t len);
+
+typedef enum {
+  ECC_CMD_CURVE_P256,
+  ECC_CMD_CURVE_SECP256K1,
+  ECC_CMD_CURVE_TOY,
+} ecc_cmd_curve_t;
+
+typedef struct {
+  uint32_t base_cycles;     ///< cycles for k * G with the comb table
+  uint32_t variable_cycles; ///< cycles for k * G with the width-4 wNAF
+  uint8_t x[ECC_CMD_SCALAR_BYTES]; ///< x coordinate of the result
+  int ok;                   ///< both methods agree
+} ecmul_bench_t;
+
+/// Time one random scalar multiplication of the generator on the selected
+/// curve, LD6 is high during the fixed-base multiplication
+void ecc_cmd_ecmul(ecmul_bench_t* result, ecc_cmd_curve_t curve);
+
+typedef struct {
+  uint32_t plain_cycles;    ///< cycles for k * P without countermeasures
+  uint32_t blinded_cycles;  ///< cycles for k * P with the selected ones
+  int ok;                   ///< both multiplications agree
+} blind_bench_t;
+
+/// Time k * P for a random k and P with and without the EC_BLIND_* set in
+/// mask, LD6 is high during the blinded multiplication
+void ecc_cmd_blind(blind_bench_t* result, ecc_cmd_curve_t curve, uint32_t mask);
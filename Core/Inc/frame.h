@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Binary framing for the UART: type (1 byte), payload length (2 bytes,
+/// little-endian), payload, CRC-16/CCITT-FALSE of everything before it
+/// (2 bytes, little-endian), COBS encoded and terminated by a 0x00 byte so a
+/// receiver can resynchronize on any delimiter.
+
+#define FRAME_MAX_PAYLOAD 256
+#define FRAME_HEADER_BYTES 3
+#define FRAME_CRC_BYTES 2
+#define FRAME_MAX_RAW (FRAME_HEADER_BYTES + FRAME_MAX_PAYLOAD + FRAME_CRC_BYTES)
+/// COBS adds one byte per 254 plus one, then the delimiter
+#define FRAME_MAX_ENCODED (FRAME_MAX_RAW + FRAME_MAX_RAW / 254 + 2)
+
+typedef enum {
+  FRAME_COMMAND = 0x01, ///< host -> device, a command line
+  FRAME_DATA = 0x02,    ///< device -> host, part of a response, more follows
+  FRAME_END = 0x03,     ///< device -> host, last part of a response
+  FRAME_UNKNOWN = 0x04, ///< device -> host, unknown command or corrupt frame
+} frame_type_t;
+
+uint16_t frame_crc16(const uint8_t* data, uint32_t len);
+
+/// Encode one frame into out, which needs FRAME_MAX_ENCODED bytes.
+/// Returns the number of bytes written including the delimiter, 0 if the
+/// payload is too long.
+uint32_t frame_encode(uint8_t* out, uint8_t type, const uint8_t* payload, uint32_t len);
+
+typedef struct {
+  uint8_t buf[FRAME_MAX_ENCODED];
+  uint32_t len;
+  int overflow;               ///< the current frame is too long, dropped
+} frame_decoder_t;
+
+void frame_decoder_init(frame_decoder_t* decoder);
+
+/// Feed one received byte. Returns 1 when it completes a valid frame, whose
+/// type and payload (FRAME_MAX_PAYLOAD bytes) are stored, -1 when it ends a
+/// corrupt or oversized frame and 0 otherwise.
+int frame_decoder_push(frame_decoder_t* decoder, uint8_t byte,
+                       uint8_t* type, uint8_t* payload, uint32_t* len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "trigger.h"
+
+/// Where the toy curve ec_mul raises the PD15 trigger, fixed at build time
+/// with TRIGGER_POLICY. The hooks of the other places expand to nothing, so
+/// every policy runs the same code between its windows and
+/// TRIGGER_POLICY_OFF leaves no store at all in ec_mul and batch for
+/// throughput measurements. The values start at 1 because a misspelled
+/// TRIGGER_POLICY_* name evaluates as 0 in #if, which is rejected below
+/// instead of building without windows.
+#define TRIGGER_POLICY_OFF 1        ///< no window, no marker, no LD3 pulse
+#define TRIGGER_POLICY_OPERATION 2  ///< one window per multiplication
+#define TRIGGER_POLICY_BIT 3        ///< one per scalar bit, addition and doubling
+#define TRIGGER_POLICY_DOUBLING 4   ///< one per doubling, 32 per multiplication
+#define TRIGGER_POLICY_ADDITION 5   ///< one per addition, only on set bits
+
+#ifndef TRIGGER_POLICY
+#define TRIGGER_POLICY TRIGGER_POLICY_DOUBLING
+#endif
+
+#if TRIGGER_POLICY < TRIGGER_POLICY_OFF || TRIGGER_POLICY > TRIGGER_POLICY_ADDITION
+#error "unknown TRIGGER_POLICY, use one of the TRIGGER_POLICY_* values"
+#endif
+
+#define TRIGGER_NONE() do {} while (0)
+
+#if TRIGGER_POLICY == TRIGGER_POLICY_OPERATION
+#define TRIGGER_OPERATION_BEGIN() TRIGGER_HIGH()
+#define TRIGGER_OPERATION_END() TRIGGER_LOW()
+#else
+#define TRIGGER_OPERATION_BEGIN() TRIGGER_NONE()
+#define TRIGGER_OPERATION_END() TRIGGER_NONE()
+#endif
+
+#if TRIGGER_POLICY == TRIGGER_POLICY_BIT
+#define TRIGGER_BIT_BEGIN() TRIGGER_HIGH()
+#define TRIGGER_BIT_END() TRIGGER_LOW()
+#else
+#define TRIGGER_BIT_BEGIN() TRIGGER_NONE()
+#define TRIGGER_BIT_END() TRIGGER_NONE()
+#endif
+
+#if TRIGGER_POLICY == TRIGGER_POLICY_DOUBLING
+#define TRIGGER_DOUBLING_BEGIN() TRIGGER_HIGH()
+#define TRIGGER_DOUBLING_END() TRIGGER_LOW()
+#else
+#define TRIGGER_DOUBLING_BEGIN() TRIGGER_NONE()
+#define TRIGGER_DOUBLING_END() TRIGGER_NONE()
+#endif
+
+#if TRIGGER_POLICY == TRIGGER_POLICY_ADDITION
+#define TRIGGER_ADDITION_BEGIN() TRIGGER_HIGH()
+#define TRIGGER_ADDITION_END() TRIGGER_LOW()
+#else
+#define TRIGGER_ADDITION_BEGIN() TRIGGER_NONE()
+#define TRIGGER_ADDITION_END() TRIGGER_NONE()
+#endif
+
+/// The marker at the start of a multiplication, the LD3 operation pulse of
+/// batch and the window around the TOY_MUL_TABLE lookup (which has neither
+/// bits nor doublings) are kept by every policy but OFF
+#if TRIGGER_POLICY != TRIGGER_POLICY_OFF
+#define TRIGGER_POLICY_MARK() TRIGGER_MARK()
+#define TRIGGER_PULSE_HIGH() OP_PULSE_HIGH()
+#define TRIGGER_PULSE_LOW() OP_PULSE_LOW()
+#define TRIGGER_LOOKUP_BEGIN() TRIGGER_HIGH()
+#define TRIGGER_LOOKUP_END() TRIGGER_LOW()
+#else
+#define TRIGGER_POLICY_MARK() TRIGGER_NONE()
+#define TRIGGER_PULSE_HIGH() TRIGGER_NONE()
+#define TRIGGER_PULSE_LOW() TRIGGER_NONE()
+#define TRIGGER_LOOKUP_BEGIN() TRIGGER_NONE()
+#define TRIGGER_LOOKUP_END() TRIGGER_NONE()
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/// Event log on ITM stimulus port 1, sent out of the SWO pin (PB3) by the
+/// TPIU that openocd configures. Each event is one 32-bit write, the id in
+/// the top byte and a 24-bit argument below, followed by a hardware local
+/// timestamp in core cycles. A write only happens when the stimulus FIFO is
+/// ready, otherwise the event is dropped, so logging never stalls the CPU
+/// and never touches the USART. Decode captures with swo_decode.py.
+///
+/// Built with -DITM_LOG=ON (ITM_LOG_ENABLE=1), otherwise ITM_EVENT compiles
+/// to nothing.
+
+#ifndef ITM_LOG_ENABLE
+#define ITM_LOG_ENABLE 0
+#endif
+
+#define ITM_LOG_PORT 1
+
+typedef enum {
+  ITM_EVT_OP_START = 1,   ///< arg: itm_op_t
+  ITM_EVT_OP_END = 2,     ///< arg: itm_op_t
+  ITM_EVT_STEP = 3,       ///< arg: bit index of a double-and-add or ladder step
+  ITM_EVT_MARK = 4,       ///< arg: free, for ad hoc markers
+} itm_event_t;
+
+typedef enum {
+  ITM_OP_TOY_MUL = 1,     ///< one toy curve ec_mul
+  ITM_OP_BATCH = 2,       ///< a whole batch capture
+} itm_op_t;
+
+/// Enable the ITM with local timestamps and periodic sync packets, the
+/// TPIU (SWO baud rate, NRZ) is left to openocd which knows the trace clock
+static inline void itm_log_init(void) {
+#if ITM_LOG_ENABLE
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  ITM->LAR = 0xC5ACCE55;
+  ITM->TCR = ITM_TCR_ITMENA_Msk | ITM_TCR_TSENA_Msk | ITM_TCR_SYNCENA_Msk |
+             (1UL << ITM_TCR_TraceBusID_Pos);
+  ITM->TER |= 1UL << ITM_LOG_PORT;
+  DWT->CTRL |= 1UL << DWT_CTRL_SYNCTAP_Pos;
+#endif
+}
+
+static inline void itm_log_event(uint32_t event, uint32_t arg) {
+  if ((ITM->TCR & ITM_TCR_ITMENA_Msk) && (ITM->TER & (1UL << ITM_LOG_PORT)) &&
+      ITM->PORT[ITM_LOG_PORT].u32 != 0) {
+    ITM->PORT[ITM_LOG_PORT].u32 = (event << 24) | (arg & 0xFFFFFF);
+  }
+}
+
+#if ITM_LOG_ENABLE
+#define ITM_EVENT(event, arg) itm_log_event((event), (arg))
+#else
+#define ITM_EVENT(event, arg) do {} while (0)
+#endif
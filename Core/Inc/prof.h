@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include "cyccnt.h"
+
+/// Cycle accounting of hot regions on the DWT cycle counter. Each region
+/// keeps count, min, max, total and a log2 histogram in a static table that
+/// the prof command dumps. Built with -DPROF=ON (PROF_ENABLE=1), otherwise
+/// the macros compile to nothing so traces and timings are untouched.
+///
+///   PROF_SCOPE(PROF_EC_ADD);          // until the end of the block
+///   PROF_BEGIN(PROF_MODPOW); ... PROF_END(PROF_MODPOW);
+///
+/// Regions nest, an outer one includes the inner ones and their recording.
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 0
+#endif
+
+typedef enum {
+  PROF_EC_MUL,
+  PROF_EC_ADD,
+  PROF_EC_DOUBLE,
+  PROF_MODINV,
+  PROF_MODPOW,
+  PROF_UART_TX,   ///< uart_io_write, queueing and waiting for room
+  PROF_UART_RX,   ///< the RX event interrupt moving DMA bytes to the ring
+  PROF_REGION_COUNT,
+} prof_region_t;
+
+/// Bucket b counts samples of 2^b to 2^(b+1) - 1 cycles, the last one
+/// everything longer
+#define PROF_BUCKETS 24
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t hist[PROF_BUCKETS];
+} prof_stats_t;
+
+/// Add one sample to a region
+void prof_record(prof_region_t region, uint32_t cycles);
+
+/// Clear every region
+void prof_reset(void);
+
+/// Accumulated samples of a region
+const prof_stats_t* prof_stats(prof_region_t region);
+
+#if PROF_ENABLE
+
+typedef struct {
+  prof_region_t region;
+  uint32_t start;
+} prof_scope_t;
+
+static inline void prof_scope_end(prof_scope_t* scope) {
+  prof_record(scope->region, cyccnt_read() - scope->start);
+}
+
+#define PROF_BEGIN(region) uint32_t prof_start_##region = cyccnt_read()
+#define PROF_END(region) prof_record(region, cyccnt_read() - prof_start_##region)
+#define PROF_SCOPE(region) \
+  prof_scope_t prof_scope_##region __attribute__((cleanup(prof_scope_end))) = \
+    {region, cyccnt_read()}
+
+#else
+
+#define PROF_BEGIN(region) do {} while (0)
+#define PROF_END(region) do {} while (0)
+#define PROF_SCOPE(region) do {} while (0)
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+/// Code and data placed in SRAM: the linker script collects .RamFunc and
+/// .RamData into the .ramfunc output section, loaded in flash and copied to
+/// SRAM by the startup next to .data. Calls between flash and SRAM are out
+/// of BL range, so SRAM functions are long calls and never inlined. The host
+/// simulation (SIM_BUILD) has a single address space and keeps them in place.
+#if SIM_BUILD
+#define RAMFUNC __attribute__((noinline))
+#define RAMDATA
+#else
+#define RAMFUNC __attribute__((section(".RamFunc"), noinline, long_call))
+#define RAMDATA __attribute__((section(".RamData")))
+#endif
+
+/// -DTOY_SRAM=ON (TOY_SRAM=1) moves the toy curve field and point operations
+/// and its generated tables to SRAM. TOY_RAMFUNC goes after static in place
+/// of inline, the functions stay inline candidates when they are in flash.
+#ifndef TOY_SRAM
+#define TOY_SRAM 0
+#endif
+
+#if TOY_SRAM
+#define TOY_RAMFUNC RAMFUNC
+#define TOY_RAMDATA RAMDATA
+#else
+#define TOY_RAMFUNC inline
+#define TOY_RAMDATA
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Lock-free single producer, single consumer byte ring. The producer (an
+/// interrupt) only writes head and the consumer (the main loop) only writes
+/// tail, both are free running and wrap through the power of two size.
+typedef struct {
+  uint8_t* data;
+  uint32_t size;
+  uint32_t head;
+  uint32_t tail;
+} ring_t;
+
+/// size must be a power of two
+void ring_init(ring_t* ring, uint8_t* storage, uint32_t size);
+
+/// Bytes waiting to be read
+uint32_t ring_count(const ring_t* ring);
+
+/// Producer side, copies as much of data as fits and returns how much
+uint32_t ring_write(ring_t* ring, const uint8_t* data, uint32_t len);
+
+/// Consumer side, copies up to len bytes and returns how many
+uint32_t ring_read(ring_t* ring, uint8_t* data, uint32_t len);
+
+/// Consumer side without copying: points data at the oldest bytes and
+/// returns how many are contiguous in the storage
+uint32_t ring_peek(const ring_t* ring, const uint8_t** data);
+
+/// Consumer side, drops len bytes returned by ring_peek
+void ring_skip(ring_t* ring, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Cooperative run-to-completion scheduler. A task is a function that runs
+/// until it returns, interrupts post it by setting its bit in a pending word
+/// and the main loop runs the posted tasks one at a time, lowest id first.
+/// Posting a task that is already pending does nothing, so an interrupt
+/// burst costs one run. A task posting itself runs again after every task
+/// of higher priority posted meanwhile.
+///
+///   while (1) {
+///     if (sched_run_pending() == 0) {
+///       __disable_irq();
+///       if (!sched_pending()) __WFI();  // a post in between wakes it
+///       __enable_irq();
+///     }
+///   }
+
+#define SCHED_MAX_TASKS 32
+
+typedef void (*sched_task_t)(void);
+
+/// Forget every task and pending post
+void sched_init(void);
+
+/// Register fn with the next id, ids added first take priority. Returns the
+/// id, or -1 once SCHED_MAX_TASKS are registered
+int sched_add(sched_task_t fn);
+
+/// Mark a task to run, from the main loop or any interrupt
+void sched_post(int id);
+
+/// Bitmask of the posted tasks, bit id for each
+uint32_t sched_pending(void);
+
+/// Run the posted tasks until none is left, returns how many ran
+uint32_t sched_run_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
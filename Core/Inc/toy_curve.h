@@ -0,0 +1,15 @@
+#pragma once
+
+/// Parameters of the 14-bit demo curve y^2 = x^3 + A x + B mod P that the
+/// firmware leaks on, shared by main.c and the curve descriptors in old/ec.h
+
+#define TOY_CURVE_A 497
+#define TOY_CURVE_B 1768
+#define TOY_CURVE_P 9739
+#define TOY_CURVE_GX 1804
+#define TOY_CURVE_GY 5368
+#define TOY_CURVE_N 9735  ///< order of G, not prime
+
+/// Printed for both coordinates when a result is the point at infinity, no
+/// coordinate reaches it since they are reduced mod P
+#define TOY_CURVE_INFINITY 0xFFFFFFFFu
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include "toy_curve.h"
+#include "ramfunc.h"
+
+/// Inversion methods for the toy curve field, pick one with TOY_MODINV.
+/// They start at 1 because a misspelled TOY_MODINV_* name evaluates as 0
+/// in #if, which is rejected below.
+#define TOY_MODINV_FERMAT 1 ///< a^(P - 2) with square-and-multiply
+#define TOY_MODINV_EUCLID 2 ///< extended Euclidean algorithm
+#define TOY_MODINV_TABLE 3  ///< lookup in inv_table, ~19 KB of flash
+
+#ifndef TOY_MODINV
+#define TOY_MODINV TOY_MODINV_FERMAT
+#endif
+
+#if TOY_MODINV < TOY_MODINV_FERMAT || TOY_MODINV > TOY_MODINV_TABLE
+#error "unknown TOY_MODINV, use TOY_MODINV_FERMAT, TOY_MODINV_EUCLID or TOY_MODINV_TABLE"
+#endif
+
+/// inv_table[a] * a = 1 mod TOY_CURVE_P for a != 0, inv_table[0] = 0.
+/// Generated at build time by cmake/toy_inv_table.cmake, only linked when
+/// TOY_MODINV is TOY_MODINV_TABLE, copied to SRAM with TOY_SRAM.
+extern const uint16_t inv_table[TOY_CURVE_P];
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+#include "toy_curve.h"
+#include "ramfunc.h"
+
+/// Build with TOY_MUL_TABLE = 1 to replace the toy curve double-and-add by
+/// a lookup in toy_mul_table, a reference without data dependent work
+#ifndef TOY_MUL_TABLE
+#define TOY_MUL_TABLE 0
+#endif
+
+/// toy_mul_table[k] = (x, y) of k * G for 0 < k < TOY_CURVE_N, entry 0 holds
+/// (1, 1) for the point at infinity. Generated at build time by
+/// cmake/toy_mul_table.cmake, ~39 KB of flash (and SRAM with TOY_SRAM),
+/// only linked when TOY_MUL_TABLE is set.
+extern const uint16_t toy_mul_table[TOY_CURVE_N][2];
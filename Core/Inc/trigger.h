@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include "main.h"
+#if SIM_BUILD
+#include "sim.h"
+#endif
+
+/// Scope trigger on PD15 (LD6) and operation pulse on PD13 (LD3) as single
+/// stores, no HAL call and no read-modify-write inside the windows.
+///
+/// With -DTRIGGER_TIMER=ON (TRIGGER_TIMER=1) PD15 is TIM4 channel 4 instead:
+/// the windows force the output compare level (one store as well) and
+/// TRIGGER_MARK emits a one-pulse of TRIGGER_MARK_TICKS timer clocks, so a
+/// segment boundary is placed by the timer rather than by the code path
+/// leading to it. Without the timer TRIGGER_MARK does nothing and traces
+/// keep only the windows.
+
+#ifndef TRIGGER_TIMER
+#define TRIGGER_TIMER 0
+#endif
+
+/// Timer clocks before and during a marker pulse
+#define TRIGGER_MARK_DELAY 1
+#define TRIGGER_MARK_TICKS 8
+
+#if SIM_BUILD
+
+// the host simulation logs every edge with a timestamp instead, the marker
+// as level 2
+#define OP_PULSE_HIGH() sim_pin(LD3_Pin, 1)
+#define OP_PULSE_LOW() sim_pin(LD3_Pin, 0)
+#define TRIGGER_HIGH() sim_pin(LD6_Pin, 1)
+#define TRIGGER_LOW() sim_pin(LD6_Pin, 0)
+#define TRIGGER_MARK() sim_pin(LD6_Pin, 2)
+
+/// every intermediate of the toy field arithmetic, for the operand trace
+/// leakage_sim.py models power from
+#define TRACE_OPERAND(v) sim_operand(v)
+
+#else
+
+#define TRACE_OPERAND(v) (v)
+
+#define OP_PULSE_HIGH() (LD3_GPIO_Port->BSRR = LD3_Pin)
+#define OP_PULSE_LOW() (LD3_GPIO_Port->BSRR = (uint32_t)LD3_Pin << 16U)
+
+#if TRIGGER_TIMER
+
+// OC4M 101 forces the output active, 100 inactive, 111 is PWM mode 2
+// (active from CCR4 to ARR), the other CCMR2 fields stay 0
+#define TRIGGER_CCMR2_HIGH (TIM_CCMR2_OC4M_2 | TIM_CCMR2_OC4M_0)
+#define TRIGGER_CCMR2_LOW TIM_CCMR2_OC4M_2
+#define TRIGGER_CCMR2_PWM2 (TIM_CCMR2_OC4M_2 | TIM_CCMR2_OC4M_1 | TIM_CCMR2_OC4M_0)
+
+#define TRIGGER_HIGH() (TIM4->CCMR2 = TRIGGER_CCMR2_HIGH)
+#define TRIGGER_LOW() (TIM4->CCMR2 = TRIGGER_CCMR2_LOW)
+/// one pulse mode clears CEN at the end of the pulse, waiting for it keeps
+/// the pulse out of the window that follows
+#define TRIGGER_MARK() do { \
+    TIM4->CCMR2 = TRIGGER_CCMR2_PWM2; \
+    TIM4->CR1 = TIM_CR1_OPM | TIM_CR1_CEN; \
+    while (TIM4->CR1 & TIM_CR1_CEN) { \
+    } \
+    TIM4->CCMR2 = TRIGGER_CCMR2_LOW; \
+  } while (0)
+
+#else
+
+#define TRIGGER_HIGH() (LD6_GPIO_Port->BSRR = LD6_Pin)
+#define TRIGGER_LOW() (LD6_GPIO_Port->BSRR = (uint32_t)LD6_Pin << 16U)
+#define TRIGGER_MARK() do {} while (0)
+
+#endif
+
+#endif
+
+/// Hand PD15 to TIM4 channel 4 when TRIGGER_TIMER is set, after
+/// MX_GPIO_Init configured it as a plain output
+static inline void trigger_init(void) {
+#if TRIGGER_TIMER && !SIM_BUILD
+  __HAL_RCC_TIM4_CLK_ENABLE();
+  TIM4->CR1 = 0;
+  TIM4->PSC = 0;
+  TIM4->ARR = TRIGGER_MARK_DELAY + TRIGGER_MARK_TICKS;
+  TIM4->CCR4 = TRIGGER_MARK_DELAY;
+  TIM4->CCMR2 = TRIGGER_CCMR2_LOW;
+  TIM4->CCER = TIM_CCER_CC4E;
+  TIM4->EGR = TIM_EGR_UG;
+  TIM4->SR = 0;
+
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+  GPIO_InitStruct.Pin = LD6_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  GPIO_InitStruct.Alternate = GPIO_AF2_TIM4;
+  HAL_GPIO_Init(LD6_GPIO_Port, &GPIO_InitStruct);
+#endif
+}
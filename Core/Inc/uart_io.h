@@ -0,0 +1,62 @@
+#pragma once
+
+#include "main.h"
+
+/// USART2 reception runs on DMA1 stream 5 in circular mode. Every idle line,
+/// half and full transfer event moves what the DMA wrote into a ring the main
+/// loop reads from, so bytes keep arriving while a command runs.
+///
+/// Transmission is queued in a second ring drained by DMA1 stream 6, each
+/// completion starts the next chunk, so the output of one result is sent
+/// while the next one is computed.
+
+/// DMA target, an event at least every half of it
+#define UART_RX_DMA_SIZE 64
+/// Ring between the interrupt and the main loop, a power of two
+#define UART_RX_RING_SIZE 2048
+/// Output queue, a power of two
+#define UART_TX_RING_SIZE 4096
+/// Longest DMA transfer, bounds how long uart_io_hold_begin waits (64 bytes
+/// take 5.6 ms at 115200 baud)
+#define UART_TX_CHUNK 64
+
+/// Start the reception, huart must be initialized with both DMAs linked
+void uart_io_start(UART_HandleTypeDef* huart);
+
+/// Recompute the baud rate divider after the APB1 clock changed, flush the
+/// output first since bytes in flight are garbled
+void uart_io_update_baud(void);
+
+/// Copy up to len received bytes, never blocks
+uint32_t uart_io_read(uint8_t* data, uint32_t len);
+
+/// Called from the reception interrupt after new bytes reach the ring, NULL
+/// for none
+void uart_io_on_receive(void (*callback)(void));
+
+/// Bytes lost because the ring was full or the UART reported an error
+uint32_t uart_io_rx_dropped(void);
+
+/// Queue data for transmission, waits only while the queue is full. While
+/// transmission is held nothing drains, what does not fit is dropped and
+/// only counted in uart_io_tx_dropped, so output that must arrive whole (the
+/// results of batch) is written after uart_io_hold_end.
+void uart_io_write(const uint8_t* data, uint32_t len);
+
+/// Queue as much of data as fits and return how much, never blocks
+uint32_t uart_io_try_write(const uint8_t* data, uint32_t len);
+
+/// Wait until everything queued is sent (returns at once while held)
+void uart_io_flush(void);
+
+/// Bytes not queued by uart_io_write because transmission was held
+uint32_t uart_io_tx_dropped(void);
+
+/// Trigger hold switch: when enabled, uart_io_hold_begin waits for the
+/// transfer in flight and no DMA transfer starts until the matching
+/// uart_io_hold_end, so UART and DMA activity stay out of the traces.
+/// Holds nest, disabled they do nothing.
+void uart_io_set_trigger_hold(int enable);
+int uart_io_trigger_hold(void);
+void uart_io_hold_begin(void);
+void uart_io_hold_end(void);
@@ -0,0 +1,34 @@
+#include <stddef.h>
+#include "arena.h"
+
+ARENA_DEFINE(scratch_arena, SCRATCH_ARENA_SIZE);
+
+void arena_init(arena_t* arena, void* storage, uint32_t capacity) {
+  arena->base = (uint8_t*)storage;
+  arena->capacity = capacity;
+  arena->used = 0;
+  arena->peak = 0;
+}
+
+void* arena_alloc(arena_t* arena, uint32_t size) {
+  uint32_t aligned = (size + ARENA_ALIGN - 1) & ~(uint32_t)(ARENA_ALIGN - 1);
+  if (aligned < size || aligned > arena->capacity - arena->used) {
+    return NULL;
+  }
+  void* block = arena->base + arena->used;
+  arena->used += aligned;
+  if (arena->used > arena->peak) {
+    arena->peak = arena->used;
+  }
+  return block;
+}
+
+uint32_t arena_mark(const arena_t* arena) {
+  return arena->used;
+}
+
+void arena_reset(arena_t* arena, uint32_t mark) {
+  if (mark < arena->used) {
+    arena->used = mark;
+  }
+}
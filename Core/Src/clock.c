@@ -0,0 +1,103 @@
+#include "clock.h"
+
+#include "main.h"
+
+typedef struct {
+  const char* name;
+  uint32_t source;    ///< RCC_PLLSOURCE_HSI or RCC_PLLSOURCE_HSE
+  uint32_t pllm;      ///< 0 without PLL
+  uint32_t plln;
+  uint32_t pllp;
+  uint32_t pllq;
+  uint32_t latency;
+  uint32_t apb1;
+} clock_config_t;
+
+// VCO = 2 MHz * N between 100 and 432 MHz, SYSCLK = VCO / P, Q keeps the
+// 48 MHz domain at or below 48 MHz
+static const clock_config_t configs[CLOCK_PROFILE_COUNT] = {
+  [CLOCK_HSI16]  = {"hsi16",  RCC_PLLSOURCE_HSI, 0, 0,   0,             0, FLASH_LATENCY_0, RCC_HCLK_DIV4},
+  [CLOCK_HSI48]  = {"hsi48",  RCC_PLLSOURCE_HSI, 8, 96,  RCC_PLLP_DIV4, 4, FLASH_LATENCY_1, RCC_HCLK_DIV2},
+  [CLOCK_HSI84]  = {"hsi84",  RCC_PLLSOURCE_HSI, 8, 168, RCC_PLLP_DIV4, 7, FLASH_LATENCY_2, RCC_HCLK_DIV2},
+  [CLOCK_HSI100] = {"hsi100", RCC_PLLSOURCE_HSI, 8, 100, RCC_PLLP_DIV2, 5, FLASH_LATENCY_3, RCC_HCLK_DIV2},
+  [CLOCK_HSE48]  = {"hse48",  RCC_PLLSOURCE_HSE, 4, 96,  RCC_PLLP_DIV4, 4, FLASH_LATENCY_1, RCC_HCLK_DIV2},
+  [CLOCK_HSE84]  = {"hse84",  RCC_PLLSOURCE_HSE, 4, 168, RCC_PLLP_DIV4, 7, FLASH_LATENCY_2, RCC_HCLK_DIV2},
+  [CLOCK_HSE100] = {"hse100", RCC_PLLSOURCE_HSE, 4, 100, RCC_PLLP_DIV2, 5, FLASH_LATENCY_3, RCC_HCLK_DIV2},
+};
+
+static clock_profile_t current = CLOCK_HSI16;
+
+const char* clock_name(clock_profile_t profile) {
+  return (uint32_t)profile < CLOCK_PROFILE_COUNT ? configs[profile].name : 0;
+}
+
+clock_profile_t clock_current(void) {
+  return current;
+}
+
+// SYSCLK from the HSI as SystemClock_Config leaves it, the PLL can then be
+// stopped and reprogrammed
+static int clock_to_hsi(void) {
+  RCC_ClkInitTypeDef clk = {0};
+  clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK |
+                  RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+  clk.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+  clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  clk.APB1CLKDivider = configs[CLOCK_HSI16].apb1;
+  clk.APB2CLKDivider = RCC_HCLK_DIV1;
+  if (HAL_RCC_ClockConfig(&clk, configs[CLOCK_HSI16].latency) != HAL_OK) {
+    return 0;
+  }
+  current = CLOCK_HSI16;
+  return 1;
+}
+
+int clock_apply(clock_profile_t profile) {
+  if ((uint32_t)profile >= CLOCK_PROFILE_COUNT) {
+    return 0;
+  }
+  if (!clock_to_hsi()) {
+    return 0;
+  }
+  const clock_config_t* config = &configs[profile];
+  if (config->pllm == 0) {
+    // nothing runs from the PLL or the HSE any more, stop them
+    RCC_OscInitTypeDef osc = {0};
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+    osc.HSEState = RCC_HSE_OFF;
+    osc.PLL.PLLState = RCC_PLL_OFF;
+    return HAL_RCC_OscConfig(&osc) == HAL_OK;
+  }
+
+  RCC_OscInitTypeDef osc = {0};
+  osc.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+  osc.HSIState = RCC_HSI_ON;
+  osc.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+  if (config->source == RCC_PLLSOURCE_HSE) {
+    osc.OscillatorType |= RCC_OSCILLATORTYPE_HSE;
+    osc.HSEState = RCC_HSE_ON;
+  }
+  osc.PLL.PLLState = RCC_PLL_ON;
+  osc.PLL.PLLSource = config->source;
+  osc.PLL.PLLM = config->pllm;
+  osc.PLL.PLLN = config->plln;
+  osc.PLL.PLLP = config->pllp;
+  osc.PLL.PLLQ = config->pllq;
+  if (HAL_RCC_OscConfig(&osc) != HAL_OK) {
+    return 0;
+  }
+
+  // raises the wait states before the frequency
+  RCC_ClkInitTypeDef clk = {0};
+  clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK |
+                  RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+  clk.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+  clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  clk.APB1CLKDivider = config->apb1;
+  clk.APB2CLKDivider = RCC_HCLK_DIV1;
+  if (HAL_RCC_ClockConfig(&clk, config->latency) != HAL_OK) {
+    return 0;
+  }
+  current = profile;
+  return 1;
+}
@@ -0,0 +1,158 @@
+#include "ecc_cmd.h"
+
+#include <string.h>
+
+#include "main.h"
+#include "cyccnt.h"
+#include "uart_io.h"
+#include "trigger.h"
+#include "ecdh.h"
+#include "ecdsa.h"
+#include "kex.h"
+
+static ec_curve_t secp256k1_curve;
+static ec_curve_t toy_curve;
+
+// Descriptors are built on first use, the comb table takes a while
+static const ec_curve_t* curve_get(ecc_cmd_curve_t id) {
+  static int ready = 0;
+  if (id == ECC_CMD_CURVE_P256) {
+    return ec_curve_p256();
+  }
+  if (!ready) {
+    ec_curve_init(&secp256k1_curve, &ec_params_secp256k1);
+    ec_curve_init(&toy_curve, &ec_params_toy);
+    ready = 1;
+  }
+  return id == ECC_CMD_CURVE_SECP256K1 ? &secp256k1_curve : &toy_curve;
+}
+
+static ff_t device_priv;
+static ECPoint device_pub;
+static int device_key_ready = 0;
+
+static void device_key(void) {
+  if (!device_key_ready) {
+    ecdh_keygen(ec_curve_p256(), &device_priv, &device_pub);
+    device_key_ready = 1;
+  }
+}
+
+void ecc_cmd_ecdh(ecdh_bench_t* result, ecc_cmd_kex_t curve) {
+  const kex_t* kex = curve == ECC_CMD_X25519 ? &kex_x25519 : &kex_p256;
+  uint8_t priv1[KEX_MAX_PRIV_BYTES], pub1[KEX_MAX_PUB_BYTES];
+  uint8_t priv2[KEX_MAX_PRIV_BYTES], pub2[KEX_MAX_PUB_BYTES];
+  uint8_t other[KEX_MAX_SECRET_BYTES];
+
+  uint32_t start = cyccnt_read();
+  kex->keygen(priv1, pub1);
+  result->keygen_cycles = cyccnt_read() - start;
+  kex->keygen(priv2, pub2);
+
+  int ok = kex->shared_secret(other, priv1, pub2);
+
+  uart_io_hold_begin();
+  TRIGGER_HIGH(); // Trigger the scope
+  start = cyccnt_read();
+  ok &= kex->shared_secret(result->secret, priv2, pub1);
+  result->exchange_cycles = cyccnt_read() - start;
+  TRIGGER_LOW();
+  uart_io_hold_end();
+
+  result->ok = ok && memcmp(other, result->secret, kex->secret_bytes) == 0;
+}
+
+void ecc_cmd_pubkey(uint8_t* point) {
+  device_key();
+  ec_encode_point(point, &device_pub, 0);
+}
+
+void ecc_cmd_sign(ecdsa_sign_bench_t* result, const uint8_t* msg, uint32_t len) {
+  uint8_t hash[ECDSA_HASH_BYTES];
+  ff_t r, s;
+
+  device_key();
+  sha256(hash, msg, len);
+
+  uart_io_hold_begin();
+  TRIGGER_HIGH(); // Trigger the scope
+  uint32_t start = cyccnt_read();
+  result->ok = ecdsa_sign(ec_curve_p256(), &r, &s, &device_priv, hash);
+  result->cycles = cyccnt_read() - start;
+  TRIGGER_LOW();
+  uart_io_hold_end();
+
+  ff_to_bytes(result->r, &r);
+  ff_to_bytes(result->s, &s);
+}
+
+void ecc_cmd_verify(ecdsa_verify_bench_t* result, const uint8_t* r, const uint8_t* s,
+                    const uint8_t* msg, uint32_t len) {
+  uint8_t hash[ECDSA_HASH_BYTES];
+  ff_t fr, fs;
+
+  device_key();
+  sha256(hash, msg, len);
+  ff_from_bytes(&fr, r);
+  ff_from_bytes(&fs, s);
+
+  uart_io_hold_begin();
+  TRIGGER_HIGH(); // Trigger the scope
+  uint32_t start = cyccnt_read();
+  result->ok = ecdsa_verify(ec_curve_p256(), &fr, &fs, &device_pub, hash);
+  result->cycles = cyccnt_read() - start;
+  TRIGGER_LOW();
+  uart_io_hold_end();
+}
+
+void ecc_cmd_ecmul(ecmul_bench_t* result, ecc_cmd_curve_t id) {
+  const ec_curve_t* curve = curve_get(id);
+  ff_t k;
+  ECPoint base, other;
+  ec_init_random_k(curve, &k);
+
+  uart_io_hold_begin();
+  TRIGGER_HIGH(); // Trigger the scope
+  uint32_t start = cyccnt_read();
+  int finite = ec_scalar_mul_base(curve, &base, &k);
+  result->base_cycles = cyccnt_read() - start;
+  TRIGGER_LOW();
+  uart_io_hold_end();
+
+  start = cyccnt_read();
+  int other_finite = ec_scalar_mul(curve, &other, &curve->g, &k);
+  result->variable_cycles = cyccnt_read() - start;
+
+  // k = 0 gives the point at infinity, reported with an all zero x
+  result->ok = finite == other_finite &&
+               (!finite || (ff_eq(&base.x, &other.x) && ff_eq(&base.y, &other.y)));
+  if (!finite) {
+    ff_zero(&base.x);
+  }
+  ff_to_bytes(result->x, &base.x);
+}
+
+void ecc_cmd_blind(blind_bench_t* result, ecc_cmd_curve_t id, uint32_t mask) {
+  const ec_curve_t* curve = curve_get(id);
+  ff_t k, d;
+  ECPoint P, plain, blinded;
+  do {
+    ec_init_random_k(curve, &d);
+  } while (!ec_scalar_mul_base(curve, &P, &d));
+  ec_init_random_k(curve, &k);
+
+  uint32_t start = cyccnt_read();
+  int finite = ec_scalar_mul(curve, &plain, &P, &k);
+  result->plain_cycles = cyccnt_read() - start;
+
+  uart_io_hold_begin();
+  TRIGGER_HIGH(); // Trigger the scope
+  start = cyccnt_read();
+  int blinded_finite = ec_scalar_mul_blinded(curve, &blinded, &P, &k, mask & EC_BLIND_ALL);
+  result->blinded_cycles = cyccnt_read() - start;
+  TRIGGER_LOW();
+  uart_io_hold_end();
+
+  result->ok = finite == blinded_finite &&
+               (!finite || (ff_eq(&plain.x, &blinded.x) && ff_eq(&plain.y, &blinded.y)));
+}
@@ -0,0 +1,122 @@
+#include "frame.h"
+
+uint16_t frame_crc16(const uint8_t* data, uint32_t len) {
+  uint16_t crc = 0xFFFF;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// COBS: every run of up to 254 non-zero bytes is prefixed by its length + 1
+// and the zero that ends it is dropped
+static uint32_t cobs_encode(uint8_t* out, const uint8_t* in, uint32_t len) {
+  uint32_t code_at = 0;
+  uint32_t used = 1;
+  uint8_t code = 1;
+  for (uint32_t i = 0; i < len; i++) {
+    if (in[i] != 0) {
+      out[used++] = in[i];
+      code++;
+    }
+    if (in[i] == 0 || code == 0xFF) {
+      out[code_at] = code;
+      code_at = used++;
+      code = 1;
+    }
+  }
+  out[code_at] = code;
+  return used;
+}
+
+// returns the decoded length, 0 if the encoding is malformed
+static uint32_t cobs_decode(uint8_t* out, const uint8_t* in, uint32_t len) {
+  uint32_t used = 0;
+  uint32_t i = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) {
+      return 0;
+    }
+    for (uint8_t j = 1; j < code; j++) {
+      out[used++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      out[used++] = 0;
+    }
+  }
+  return used;
+}
+
+uint32_t frame_encode(uint8_t* out, uint8_t type, const uint8_t* payload, uint32_t len) {
+  uint8_t raw[FRAME_MAX_RAW];
+  if (len > FRAME_MAX_PAYLOAD) {
+    return 0;
+  }
+  raw[0] = type;
+  raw[1] = (uint8_t)len;
+  raw[2] = (uint8_t)(len >> 8);
+  for (uint32_t i = 0; i < len; i++) {
+    raw[FRAME_HEADER_BYTES + i] = payload[i];
+  }
+  uint16_t crc = frame_crc16(raw, FRAME_HEADER_BYTES + len);
+  raw[FRAME_HEADER_BYTES + len] = (uint8_t)crc;
+  raw[FRAME_HEADER_BYTES + len + 1] = (uint8_t)(crc >> 8);
+
+  uint32_t used = cobs_encode(out, raw, FRAME_HEADER_BYTES + len + FRAME_CRC_BYTES);
+  out[used++] = 0;
+  return used;
+}
+
+void frame_decoder_init(frame_decoder_t* decoder) {
+  decoder->len = 0;
+  decoder->overflow = 0;
+}
+
+int frame_decoder_push(frame_decoder_t* decoder, uint8_t byte,
+                       uint8_t* type, uint8_t* payload, uint32_t* len) {
+  if (byte != 0) {
+    if (decoder->len < sizeof(decoder->buf)) {
+      decoder->buf[decoder->len++] = byte;
+    } else {
+      decoder->overflow = 1;
+    }
+    return 0;
+  }
+
+  // a delimiter, decode what came before it
+  uint32_t encoded = decoder->len;
+  int overflow = decoder->overflow;
+  frame_decoder_init(decoder);
+  if (encoded == 0) {
+    return 0;   // back to back delimiters, nothing lost
+  }
+  if (overflow) {
+    return -1;
+  }
+
+  uint8_t raw[FRAME_MAX_ENCODED];
+  uint32_t raw_len = cobs_decode(raw, decoder->buf, encoded);
+  if (raw_len < FRAME_HEADER_BYTES + FRAME_CRC_BYTES) {
+    return -1;
+  }
+  uint32_t payload_len = raw[1] | ((uint32_t)raw[2] << 8);
+  if (payload_len > FRAME_MAX_PAYLOAD ||
+      raw_len != FRAME_HEADER_BYTES + payload_len + FRAME_CRC_BYTES) {
+    return -1;
+  }
+  uint16_t crc = raw[raw_len - 2] | (uint16_t)(raw[raw_len - 1] << 8);
+  if (crc != frame_crc16(raw, raw_len - FRAME_CRC_BYTES)) {
+    return -1;
+  }
+
+  *type = raw[0];
+  for (uint32_t i = 0; i < payload_len; i++) {
+    payload[i] = raw[FRAME_HEADER_BYTES + i];
+  }
+  *len = payload_len;
+  return 1;
+}
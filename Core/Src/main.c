@@ -26,6 +26,21 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "prng.h"
+#include "cyccnt.h"
+#include "ecc_cmd.h"
+#include "toy_curve.h"
+#include "toy_inv_table.h"
+#include "toy_mul_table.h"
+#include "frame.h"
+#include "uart_io.h"
+#include "clock.h"
+#include "prof.h"
+#include "itm_log.h"
+#include "trigger.h"
+#include "instrument.h"
+#include "ramfunc.h"
+#include "arena.h"
+#include "sched.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -45,6 +60,8 @@
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
 
@@ -53,9 +70,17 @@ UART_HandleTypeDef huart2;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN PFP */
-
+static int run_batch(uint32_t count, uint32_t gap_us, uint32_t pulse);
+static int run_tvla(uint32_t count, uint32_t gap_us);
+static int set_base_point(uint32_t x, uint32_t y);
+static int set_fixed_scalar(uint32_t k);
+static void run_mul(void);
+static void bench_modinv(void);
+static void bench_reduce(void);
+static void bench_ramfunc(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -73,77 +98,1100 @@ static inline void to_hex(uint8_t* dest, uint32_t value) {
   }
 }
 
-// curve parameters
-const uint32_t A = 497;
-const uint32_t B = 1768;
-const uint32_t P = 9739;
-const uint32_t Gx = 1804;
-const uint32_t Gy = 5368;
+static const uint8_t response[] = "\r\n:";
+
+// binary mode replaces the text console with frames (frame.h): commands
+// arrive as FRAME_COMMAND, the values of a response are packed raw into
+// FRAME_DATA frames and the last one is a FRAME_END
+static int binary_mode = 0;
+static uint8_t frame_payload[FRAME_MAX_PAYLOAD];
+static uint32_t frame_payload_len = 0;
+static int response_closed = 0;
+static frame_decoder_t frame_decoder;
+
+static void send_frame(uint8_t type) {
+  static uint8_t encoded[FRAME_MAX_ENCODED];
+  uint32_t len = frame_encode(encoded, type, frame_payload, frame_payload_len);
+  uart_io_write(encoded, len);
+  frame_payload_len = 0;
+  response_closed = type != FRAME_DATA;
+}
+
+static void frame_append(const uint8_t* data, uint32_t len) {
+  for (uint32_t i = 0; i < len; i++) {
+    if (frame_payload_len == sizeof(frame_payload)) {
+      send_frame(FRAME_DATA);
+    }
+    frame_payload[frame_payload_len++] = data[i];
+  }
+}
+
+// print a value on its own response line
+static void send_value(uint32_t value) {
+  if (binary_mode) {
+    uint8_t be[4] = { value >> 24, value >> 16, value >> 8, value };
+    frame_append(be, sizeof(be));
+    return;
+  }
+  uint8_t ffprint[8];
+  to_hex(ffprint, value);
+  uart_io_write(response, sizeof(response));
+  uart_io_write(ffprint, sizeof(ffprint));
+}
+
+// print a big-endian byte string on its own response line
+static void send_bytes(const uint8_t* data, uint32_t len) {
+  static const uint8_t hex[] = "0123456789ABCDEF";
+  if (binary_mode) {
+    frame_append(data, len);
+    return;
+  }
+  uart_io_write(response, sizeof(response));
+  for (uint32_t i = 0; i < len; i++) {
+    uint8_t pair[2] = { hex[data[i] >> 4], hex[data[i] & 0xF] };
+    uart_io_write(pair, sizeof(pair));
+  }
+}
+
+// match the first word of the line, args is set to what follows the space
+static int command_is(const uint8_t* line, uint32_t len, const char* name,
+                      const uint8_t** args, uint32_t* args_len) {
+  uint32_t i = 0;
+  for (; name[i] != '\0'; i++) {
+    if (i >= len || line[i] != (uint8_t)name[i]) {
+      return 0;
+    }
+  }
+  if (i < len) {
+    if (line[i] != ' ') {
+      return 0;
+    }
+    i++;
+  }
+  *args = line + i;
+  *args_len = len - i;
+  return 1;
+}
+
+// [secp256k1|toy] of ecmul and blind, P-256 without an argument. Returns 0
+// for anything else.
+static int parse_curve(const uint8_t* args, uint32_t args_len, ecc_cmd_curve_t* curve) {
+  const uint8_t* rest;
+  uint32_t rest_len;
+  if (args_len == 0) {
+    *curve = ECC_CMD_CURVE_P256;
+  } else if (command_is(args, args_len, "secp256k1", &rest, &rest_len) && rest_len == 0) {
+    *curve = ECC_CMD_CURVE_SECP256K1;
+  } else if (command_is(args, args_len, "toy", &rest, &rest_len) && rest_len == 0) {
+    *curve = ECC_CMD_CURVE_TOY;
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+static int hex_digit(uint8_t c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// parse exactly out_len bytes of hex followed by a space or the end of the
+// line, returns the number of characters consumed or 0 on malformed input
+static uint32_t parse_hex(const uint8_t* text, uint32_t len, uint8_t* out, uint32_t out_len) {
+  if (len < 2 * out_len) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < out_len; i++) {
+    int high = hex_digit(text[2 * i]);
+    int low = hex_digit(text[2 * i + 1]);
+    if (high < 0 || low < 0) {
+      return 0;
+    }
+    out[i] = (uint8_t)((high << 4) | low);
+  }
+  uint32_t used = 2 * out_len;
+  if (used < len) {
+    if (text[used] != ' ') {
+      return 0;
+    }
+    used++;
+  }
+  return used;
+}
+
+// parse 8 hex digits as a big-endian 32-bit value, see parse_hex
+static uint32_t parse_hex_u32(const uint8_t* text, uint32_t len, uint32_t* value) {
+  uint8_t bytes[4];
+  uint32_t used = parse_hex(text, len, bytes, sizeof(bytes));
+  if (used != 0) {
+    *value = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+             ((uint32_t)bytes[2] << 8) | bytes[3];
+  }
+  return used;
+}
+
+// parse a decimal number followed by a space or the end of the line,
+// returns the number of characters consumed or 0 on malformed input
+static uint32_t parse_u32(const uint8_t* text, uint32_t len, uint32_t* value) {
+  uint32_t used = 0;
+  *value = 0;
+  while (used < len && text[used] >= '0' && text[used] <= '9') {
+    if (*value > (UINT32_MAX - 9) / 10) {
+      return 0;
+    }
+    *value = *value * 10 + (text[used] - '0');
+    used++;
+  }
+  if (used == 0) {
+    return 0;
+  }
+  if (used < len) {
+    if (text[used] != ' ') {
+      return 0;
+    }
+    used++;
+  }
+  return used;
+}
+
+// in binary mode values can also be sent as 4 raw big-endian bytes, every
+// toy curve value is below 2^16 so the first byte is 0 and never a hex digit
+static uint32_t parse_raw_u32(const uint8_t* data, uint32_t len, uint32_t* value) {
+  if (!binary_mode || len < 4 || data[0] != 0) {
+    return 0;
+  }
+  *value = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+           ((uint32_t)data[2] << 8) | data[3];
+  return 4;
+}
+
+// run a command typed on the line, an empty line keeps the original behaviour
+// of generating a toy curve secret
+static void run_command(const uint8_t* line, uint32_t len) {
+  const uint8_t* args;
+  uint32_t args_len;
+
+  if (command_is(line, len, "binary", &args, &args_len)) {
+    // binary: ok flag, then switch to frames until a framed "text" command
+    send_value(1);
+    binary_mode = 1;
+    return;
+  }
+
+  if (command_is(line, len, "text", &args, &args_len)) {
+    // text: ok flag, the frame carrying it is the last one
+    send_value(1);
+    send_frame(FRAME_END);
+    binary_mode = 0;
+    return;
+  }
+
+  if (command_is(line, len, "txhold", &args, &args_len)) {
+    // txhold [0|1]: hold UART output during trigger windows, prints the
+    // setting
+    if (args_len == 1 && (args[0] == '0' || args[0] == '1')) {
+      uart_io_set_trigger_hold(args[0] == '1');
+    } else if (args_len != 0) {
+      send_value(0);
+      return;
+    }
+    send_value(uart_io_trigger_hold());
+    return;
+  }
+
+  if (command_is(line, len, "clock", &args, &args_len)) {
+    // clock [hsi16|hsi48|hsi84|hsi100|hse48|hse84|hse100]: ok flag, profile
+    // number and core frequency, after switching when a profile is given
+    int ok = 1;
+    if (args_len > 0) {
+      clock_profile_t profile = 0;
+      const uint8_t* rest;
+      uint32_t rest_len;
+      while (profile < CLOCK_PROFILE_COUNT &&
+             !(command_is(args, args_len, clock_name(profile), &rest, &rest_len) && rest_len == 0)) {
+        profile++;
+      }
+      if (profile == CLOCK_PROFILE_COUNT) {
+        send_value(0);
+        return;
+      }
+      uart_io_flush();
+      ok = clock_apply(profile);
+      uart_io_update_baud();
+    }
+    send_value(ok);
+    send_value(clock_current());
+    send_value(SystemCoreClock);
+    return;
+  }
+
+  if (command_is(line, len, "prof", &args, &args_len)) {
+    // prof [reset]: PROF_ENABLE, then count, min, max, mean and the log2
+    // histogram of every region, or clear them
+    const uint8_t* rest;
+    uint32_t rest_len;
+    if (command_is(args, args_len, "reset", &rest, &rest_len) && rest_len == 0) {
+      prof_reset();
+      send_value(1);
+      return;
+    }
+    send_value(PROF_ENABLE);
+    for (uint32_t i = 0; i < PROF_REGION_COUNT; i++) {
+      const prof_stats_t* stats = prof_stats(i);
+      uint8_t hist[PROF_BUCKETS * 4];
+      for (uint32_t b = 0; b < PROF_BUCKETS; b++) {
+        hist[4 * b] = stats->hist[b] >> 24;
+        hist[4 * b + 1] = stats->hist[b] >> 16;
+        hist[4 * b + 2] = stats->hist[b] >> 8;
+        hist[4 * b + 3] = stats->hist[b];
+      }
+      send_value(stats->count);
+      send_value(stats->min);
+      send_value(stats->max);
+      send_value(stats->count ? (uint32_t)(stats->total / stats->count) : 0);
+      send_bytes(hist, sizeof(hist));
+    }
+    return;
+  }
+
+  if (command_is(line, len, "ecdh", &args, &args_len)) {
+    // ecdh [x25519]: ok flag, keygen cycles, exchange cycles, secret
+    const uint8_t* rest;
+    uint32_t rest_len;
+    ecdh_bench_t bench;
+    if (args_len == 0) {
+      ecc_cmd_ecdh(&bench, ECC_CMD_P256);
+    } else if (command_is(args, args_len, "x25519", &rest, &rest_len) && rest_len == 0) {
+      ecc_cmd_ecdh(&bench, ECC_CMD_X25519);
+    } else {
+      send_value(0);
+      return;
+    }
+    send_value(bench.ok);
+    send_value(bench.keygen_cycles);
+    send_value(bench.exchange_cycles);
+    send_bytes(bench.secret, sizeof(bench.secret));
+    return;
+  }
+
+  if (command_is(line, len, "ecmul", &args, &args_len)) {
+    // ecmul [secp256k1|toy]: ok flag, comb cycles, wNAF cycles, x
+    ecc_cmd_curve_t curve;
+    ecmul_bench_t bench;
+    if (!parse_curve(args, args_len, &curve)) {
+      send_value(0);
+      return;
+    }
+    ecc_cmd_ecmul(&bench, curve);
+    send_value(bench.ok);
+    send_value(bench.base_cycles);
+    send_value(bench.variable_cycles);
+    send_bytes(bench.x, sizeof(bench.x));
+    return;
+  }
+
+  if (command_is(line, len, "blind", &args, &args_len)) {
+    // blind <mask> [secp256k1|toy]: ok flag, plain cycles, blinded cycles
+    ecc_cmd_curve_t curve;
+    blind_bench_t bench;
+    int mask = args_len > 0 ? hex_digit(args[0]) : -1;
+    if (mask < 0 || (args_len > 1 && args[1] != ' ')) {
+      send_value(0);
+      return;
+    }
+    args += args_len > 1 ? 2 : 1;
+    args_len -= args_len > 1 ? 2 : 1;
+    if (!parse_curve(args, args_len, &curve)) {
+      send_value(0);
+      return;
+    }
+    ecc_cmd_blind(&bench, curve, (uint32_t)mask);
+    send_value(bench.ok);
+    send_value(bench.plain_cycles);
+    send_value(bench.blinded_cycles);
+    return;
+  }
+
+  if (command_is(line, len, "batch", &args, &args_len)) {
+    // batch <count> [gap_us [pulse]]: secret, x, y of every operation
+    uint32_t count, gap_us = 0, pulse = 1;
+    uint32_t used = parse_u32(args, args_len, &count);
+    if (used != 0 && used < args_len) {
+      uint32_t more = parse_u32(args + used, args_len - used, &gap_us);
+      used = more != 0 ? used + more : 0;
+    }
+    if (used != 0 && used < args_len) {
+      uint32_t more = parse_u32(args + used, args_len - used, &pulse);
+      used = more != 0 && used + more == args_len ? used + more : 0;
+    }
+    if (used == 0 || !run_batch(count, gap_us, pulse)) {
+      send_value(0);
+    }
+    return;
+  }
+
+  if (command_is(line, len, "seed", &args, &args_len)) {
+    // seed <16 hex digits>: restart the PRNG from this splitmix64 seed
+    uint8_t bytes[8];
+    if (parse_hex(args, args_len, bytes, sizeof(bytes)) != args_len) {
+      send_value(0);
+      return;
+    }
+    uint64_t seed = 0;
+    for (uint32_t i = 0; i < sizeof(bytes); i++) {
+      seed = (seed << 8) | bytes[i];
+    }
+    seedRand(seed);
+    send_value(1);
+    return;
+  }
+
+  if (command_is(line, len, "scalar", &args, &args_len)) {
+    // scalar <k>: fixed scalar for mul and tvla, ok flag
+    uint32_t k;
+    uint32_t used = parse_raw_u32(args, args_len, &k);
+    if (used == 0) {
+      used = parse_hex_u32(args, args_len, &k);
+    }
+    send_value(used != 0 && used == args_len && set_fixed_scalar(k));
+    return;
+  }
+
+  if (command_is(line, len, "point", &args, &args_len)) {
+    // point [<x> <y>]: base point for batch, mul and tvla, G without
+    // arguments, ok flag
+    uint32_t x = TOY_CURVE_GX, y = TOY_CURVE_GY;
+    uint32_t used = 0;
+    if (args_len == 8 && parse_raw_u32(args, 4, &x) && parse_raw_u32(args + 4, 4, &y)) {
+      used = 8;
+    } else if (args_len > 0) {
+      used = parse_hex_u32(args, args_len, &x);
+      uint32_t more = used != 0 ? parse_hex_u32(args + used, args_len - used, &y) : 0;
+      used = more != 0 ? used + more : 0;
+    }
+    send_value(used == args_len && set_base_point(x, y));
+    return;
+  }
+
+  if (command_is(line, len, "mul", &args, &args_len)) {
+    // mul: x, y of the fixed scalar times the base point
+    run_mul();
+    return;
+  }
+
+  if (command_is(line, len, "tvla", &args, &args_len)) {
+    // tvla <count> [gap_us]: class bitmap, then secret, x, y per operation
+    uint32_t count, gap_us = 0;
+    uint32_t used = parse_u32(args, args_len, &count);
+    if (used != 0 && used < args_len) {
+      uint32_t more = parse_u32(args + used, args_len - used, &gap_us);
+      used = more != 0 && used + more == args_len ? used + more : 0;
+    }
+    if (used == 0 || !run_tvla(count, gap_us)) {
+      send_value(0);
+    }
+    return;
+  }
+
+  if (command_is(line, len, "modinv", &args, &args_len)) {
+    // modinv: TOY_MODINV, ok flag, total cycles of Fermat, Euclid and table
+    bench_modinv();
+    return;
+  }
+
+  if (command_is(line, len, "reduce", &args, &args_len)) {
+    // reduce: ok flag, min/max/total cycles of UDIV, then of mod_p
+    bench_reduce();
+    return;
+  }
+
+  if (command_is(line, len, "ramfunc", &args, &args_len)) {
+    // ramfunc: TOY_SRAM, then per clock profile the ok flag and the cycles
+    // of a multiplication chain from flash, flash with the ART and SRAM
+    bench_ramfunc();
+    return;
+  }
+
+  if (command_is(line, len, "mem", &args, &args_len)) {
+    // mem: scratch arena capacity, bytes in use and the peak since reset,
+    // then the UART bytes dropped on reception and while output was held
+    send_value(scratch_arena.capacity);
+    send_value(scratch_arena.used);
+    send_value(scratch_arena.peak);
+    send_value(uart_io_rx_dropped());
+    send_value(uart_io_tx_dropped());
+    return;
+  }
+
+  if (command_is(line, len, "pubkey", &args, &args_len)) {
+    uint8_t point[ECC_CMD_POINT_BYTES];
+    ecc_cmd_pubkey(point);
+    send_bytes(point, sizeof(point));
+    return;
+  }
+
+  if (command_is(line, len, "sign", &args, &args_len)) {
+    // sign <message>: ok flag, cycles, r, s
+    ecdsa_sign_bench_t bench;
+    ecc_cmd_sign(&bench, args, args_len);
+    send_value(bench.ok);
+    send_value(bench.cycles);
+    send_bytes(bench.r, sizeof(bench.r));
+    send_bytes(bench.s, sizeof(bench.s));
+    return;
+  }
+
+  if (command_is(line, len, "verify", &args, &args_len)) {
+    // verify <r hex> <s hex> <message>: ok flag, cycles
+    uint8_t r[ECC_CMD_SCALAR_BYTES], s[ECC_CMD_SCALAR_BYTES];
+    uint32_t used = parse_hex(args, args_len, r, sizeof(r));
+    uint32_t used_s = used ? parse_hex(args + used, args_len - used, s, sizeof(s)) : 0;
+    if (used_s) {
+      used += used_s;
+      ecdsa_verify_bench_t bench;
+      ecc_cmd_verify(&bench, r, s, args + used, args_len - used);
+      send_value(bench.ok);
+      send_value(bench.cycles);
+      return;
+    }
+  }
+
+  if (binary_mode) {
+    frame_payload_len = 0;
+    send_frame(FRAME_UNKNOWN);
+    return;
+  }
+  uint8_t unknown[] = "\r\n?";
+  uart_io_write(unknown, sizeof(unknown) - 1);
+}
+
+// curve parameters, shared with the descriptors in old/ec.h
+const uint32_t A = TOY_CURVE_A;
+const uint32_t B = TOY_CURVE_B;
+const uint32_t P = TOY_CURVE_P;
+const uint32_t Gx = TOY_CURVE_GX;
+const uint32_t Gy = TOY_CURVE_GY;
 // Group order
-const uint32_t N = 9735;
+const uint32_t N = TOY_CURVE_N;
 
+// Jacobian point, (X, Y, Z) stands for (X / Z^2, Y / Z^3) and Z = 0 is the
+// point at infinity, so no coordinate pair is reserved for it
 typedef struct {
   uint32_t x;
   uint32_t y;
+  uint32_t z;
 } ECPoint;
 
-uint32_t modpow(uint32_t base, uint32_t exp, uint32_t mod) {
+// floor(2^32 / P), see mod_p
+#define P_RECIPROCAL ((uint32_t)((UINT64_C(1) << 32) / TOY_CURVE_P))
+
+// x mod P without a division (Barrett): the UMULL quotient estimate is at
+// most one too small, the final subtraction is masked instead of branched
+// so every input takes the same cycles, unlike UDIV whose latency depends
+// on the operands
+static inline uint32_t mod_p(uint32_t x) {
+  uint32_t q = (uint32_t)(((uint64_t)x * P_RECIPROCAL) >> 32);
+  uint32_t r = x - q * P;
+  return TRACE_OPERAND(r - (P & -(uint32_t)(r >= P)));
+}
+
+// coordinates stay below P, so every product fits in 32 bits
+static inline uint32_t mod_mul(uint32_t a, uint32_t b) {
+  return mod_p(TRACE_OPERAND(a * b));
+}
+
+static inline uint32_t mod_sub(uint32_t a, uint32_t b) {
+  return mod_p(TRACE_OPERAND(a + P - b));
+}
+
+static TOY_RAMFUNC uint32_t modpow(uint32_t base, uint32_t exp) {
+   PROF_SCOPE(PROF_MODPOW);
    // we are ok with 32 bit because P*P < 2^32
    uint32_t result = 1;
    uint32_t b = base;
    
    while (exp > 0) {
        if (exp & 1)
-           result = (result * b) % mod;
-       b = (b * b) % mod;
+           result = mod_mul(result, b);
+       b = mod_mul(b, b);
        exp >>= 1;
    }
    return result;
 }
 // compute modular inverse by using Fermat's little theorem since we work on a prime
-// field, otherwise we would use the extended Euclidean algorithm
-static inline uint32_t modinv(uint32_t a, uint32_t m) {
-  return modpow(a, m - 2, m);
+// field
+static inline uint32_t modinv_fermat(uint32_t a) {
+  return modpow(a, P - 2);
 }
 
-static inline ECPoint ec_add(ECPoint a, ECPoint b) {
-  ECPoint result;
-  uint32_t lambda;
+// extended Euclidean algorithm, a handful of divisions instead of the ~28
+// modular reductions of the exponentiation
+static inline uint32_t modinv_euclid(uint32_t a) {
+  int32_t t = 0, new_t = 1;
+  int32_t r = (int32_t)P, new_r = (int32_t)mod_p(a);
+  while (new_r != 0) {
+    int32_t q = r / new_r;
+    int32_t tmp = t - q * new_t;
+    t = new_t;
+    new_t = tmp;
+    tmp = r - q * new_r;
+    r = new_r;
+    new_r = tmp;
+  }
+  return t < 0 ? (uint32_t)(t + (int32_t)P) : (uint32_t)t;
+}
 
-  if (a.x == 0 && a.y == 0) {
-    return b;
+#if TOY_MODINV == TOY_MODINV_TABLE
+static inline uint32_t modinv_table(uint32_t a) {
+  return inv_table[mod_p(a)];
+}
+#endif
+
+// the inversion selected with TOY_MODINV at build time
+static inline uint32_t modinv(uint32_t a) {
+  PROF_SCOPE(PROF_MODINV);
+#if TOY_MODINV == TOY_MODINV_TABLE
+  return modinv_table(a);
+#elif TOY_MODINV == TOY_MODINV_EUCLID
+  return modinv_euclid(a);
+#else
+  return modinv_fermat(a);
+#endif
+}
+
+// the point operations of the double-and-add ec_mul, the table build has no
+// other caller
+#if !TOY_MUL_TABLE
+// R = 2R with dbl-2007-bl, Z3 = 2YZ is zero for the point at infinity and
+// for points of order two so neither needs a branch. With TOY_SRAM this and
+// the other hot toy curve functions run from SRAM, mod_mul and mod_p are
+// inlined into them so the reductions come along.
+static TOY_RAMFUNC void ec_double_inplace(ECPoint* r) {
+  PROF_SCOPE(PROF_EC_DOUBLE);
+  uint32_t yy = mod_mul(r->y, r->y);
+  uint32_t s = mod_mul(mod_p(4 * r->x), yy);
+  uint32_t zz = mod_mul(r->z, r->z);
+  uint32_t m = mod_p(3 * mod_mul(r->x, r->x) + mod_mul(A, mod_mul(zz, zz)));
+  uint32_t x3 = mod_sub(mod_mul(m, m), mod_p(2 * s));
+  r->z = mod_mul(mod_p(2 * r->y), r->z);
+  r->y = mod_sub(mod_mul(m, mod_sub(s, x3)), mod_p(8 * mod_mul(yy, yy)));
+  r->x = x3;
+}
+
+// R += Q with add-2007-bl
+static TOY_RAMFUNC void ec_add_inplace(ECPoint* r, const ECPoint* q) {
+  PROF_SCOPE(PROF_EC_ADD);
+  if (q->z == 0) {
+    return;
   }
-  if (b.x == 0 && b.y == 0) {
-    return a;
+  if (r->z == 0) {
+    *r = *q;
+    return;
   }
 
-  if (a.x == b.x && a.y == -b.y) {
-    result.x = 0;
-    result.y = 0;
-    return result;
+  uint32_t z1z1 = mod_mul(r->z, r->z);
+  uint32_t z2z2 = mod_mul(q->z, q->z);
+  uint32_t u1 = mod_mul(r->x, z2z2);
+  uint32_t u2 = mod_mul(q->x, z1z1);
+  uint32_t s1 = mod_mul(mod_mul(r->y, q->z), z2z2);
+  uint32_t s2 = mod_mul(mod_mul(q->y, r->z), z1z1);
+  uint32_t h = mod_sub(u2, u1);
+  uint32_t t = mod_sub(s2, s1);
+
+  if (h == 0) {
+    if (t == 0) {
+      ec_double_inplace(r);
+    } else {
+      r->z = 0;
+    }
+    return;
+  }
+
+  uint32_t hh = mod_mul(h, h);
+  uint32_t hhh = mod_mul(h, hh);
+  uint32_t v = mod_mul(u1, hh);
+  uint32_t x3 = mod_sub(mod_sub(mod_mul(t, t), hhh), mod_p(2 * v));
+  r->y = mod_sub(mod_mul(t, mod_sub(v, x3)), mod_mul(s1, hhh));
+  r->x = x3;
+  r->z = mod_mul(mod_mul(r->z, q->z), h);
+}
+#endif
+
+#if TOY_MUL_TABLE
+// result = k * G read from toy_mul_table, g must be G. LD6 is high during the
+// lookup unless TRIGGER_POLICY is OFF. k must be below 2N, which holds for
+// secrets drawn below P, so one masked subtraction reduces it and the only
+// secret dependent operation is the address of a single load.
+static TOY_RAMFUNC void ec_mul(ECPoint* result, uint32_t k, const ECPoint* g) {
+  PROF_SCOPE(PROF_EC_MUL);
+  (void)g;
+  uart_io_hold_begin();
+  ITM_EVENT(ITM_EVT_OP_START, ITM_OP_TOY_MUL);
+  TRIGGER_POLICY_MARK();
+  TRIGGER_LOOKUP_BEGIN(); // Turn on the LED
+  uint32_t i = k - (N & -(uint32_t)(k >= N));
+  result->x = toy_mul_table[i][0];
+  result->y = toy_mul_table[i][1];
+  result->z = (uint32_t)(i != 0);
+  TRIGGER_LOOKUP_END(); // Turn off the LED
+  ITM_EVENT(ITM_EVT_OP_END, ITM_OP_TOY_MUL);
+  uart_io_hold_end();
+}
+#else
+// result = k * G, LD6 is high during the steps TRIGGER_POLICY selects (every
+// doubling by default, see instrument.h). The result stays in Jacobian form,
+// the caller converts it once.
+static TOY_RAMFUNC void ec_mul(ECPoint* result, uint32_t k, const ECPoint* g) {
+  PROF_SCOPE(PROF_EC_MUL);
+  ECPoint p = *g;
+  result->x = 1;
+  result->y = 1;
+  result->z = 0;
+  uart_io_hold_begin();
+  ITM_EVENT(ITM_EVT_OP_START, ITM_OP_TOY_MUL);
+  TRIGGER_POLICY_MARK();
+  TRIGGER_OPERATION_BEGIN();
+  for (int i = 0; i < 32; i++) {
+    ITM_EVENT(ITM_EVT_STEP, i);
+    TRIGGER_BIT_BEGIN();
+    if (k & (1 << i)) {
+      TRIGGER_ADDITION_BEGIN();
+      ec_add_inplace(result, &p);
+      TRIGGER_ADDITION_END();
+    }
+    TRIGGER_DOUBLING_BEGIN(); // Turn on the LED
+    ec_double_inplace(&p);
+    TRIGGER_DOUBLING_END(); // Turn off the LED
+    TRIGGER_BIT_END();
+  }
+  TRIGGER_OPERATION_END();
+  ITM_EVENT(ITM_EVT_OP_END, ITM_OP_TOY_MUL);
+  uart_io_hold_end();
+}
+#endif
+
+// affine coordinates of a finite point, returns 0 for the point at infinity
+static inline int ec_to_affine(const ECPoint* p, uint32_t* x, uint32_t* y) {
+  if (p->z == 0) {
+    return 0;
+  }
+  uint32_t zinv = modinv(p->z);
+  uint32_t zinv2 = mod_mul(zinv, zinv);
+  *x = mod_mul(p->x, zinv2);
+  *y = mod_mul(p->y, mod_mul(zinv2, zinv));
+  return 1;
+}
+
+#define BATCH_MAX 512
+
+static uint32_t batch_secrets[BATCH_MAX];
+static ECPoint batch_points[BATCH_MAX];
+
+// inputs chosen over the UART, G and no fixed scalar after reset
+static ECPoint base_point = {TOY_CURVE_GX, TOY_CURVE_GY, 1};
+static uint32_t fixed_scalar = 0;
+
+// busy wait on the cycle counter, keeps the bus quiet between operations.
+// The cycle count takes 64 bits since gap_us is a full uint32_t and CYCCNT
+// wraps after about 43 s at 100 MHz, so it is waited out in slices
+static void delay_us(uint32_t us) {
+  uint64_t cycles = (uint64_t)us * (SystemCoreClock / 1000000);
+  while (cycles != 0) {
+    uint32_t slice = cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+    uint32_t start = cyccnt_read();
+    while (cyccnt_read() - start < slice) {
+    }
+    cycles -= slice;
   }
+}
+
+// multiply base_point by the first count batch secrets back to back so one
+// acquisition holds them all. With pulse set LD3 (PD13) is high for each
+// whole operation, next to the per-doubling windows on LD6.
+static void batch_capture(uint32_t count, uint32_t gap_us, uint32_t pulse) {
+  uart_io_hold_begin();
+  ITM_EVENT(ITM_EVT_OP_START, ITM_OP_BATCH);
+  for (uint32_t i = 0; i < count; i++) {
+    if (pulse) {
+      TRIGGER_PULSE_HIGH();
+    }
+    ec_mul(&batch_points[i], batch_secrets[i], &base_point);
+    if (pulse) {
+      TRIGGER_PULSE_LOW();
+    }
+    delay_us(gap_us);
+  }
+  ITM_EVENT(ITM_EVT_OP_END, ITM_OP_BATCH);
+  uart_io_hold_end();
+}
+
+// convert and print secret, x and y of every operation once the capture is
+// over, in the format of an empty line
+static void batch_send(uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t x, y;
+    if (!ec_to_affine(&batch_points[i], &x, &y)) {
+      x = TOY_CURVE_INFINITY;
+      y = TOY_CURVE_INFINITY;
+    }
+    send_value(batch_secrets[i]);
+    send_value(x);
+    send_value(y);
+  }
+}
+
+// count random secrets times the base point, results are sent once the last
+// one is done. Returns 0 if count is out of range.
+static int run_batch(uint32_t count, uint32_t gap_us, uint32_t pulse) {
+  if (count == 0 || count > BATCH_MAX) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    batch_secrets[i] = nextRand() % P;
+  }
+  batch_capture(count, gap_us, pulse);
+  batch_send(count);
+  return 1;
+}
+
+// fixed vs random test vector leakage assessment: every operation uses the
+// fixed scalar or a fresh random one, picked by a random bit so the two
+// classes interleave. Prints the classes as a bitmap (bit i of byte i / 8 is
+// 1 for random), then the usual secret, x, y of every operation.
+static int run_tvla(uint32_t count, uint32_t gap_us) {
+  static uint8_t classes[BATCH_MAX / 8];
+  if (count == 0 || count > BATCH_MAX) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < sizeof(classes); i++) {
+    classes[i] = 0;
+  }
+  for (uint32_t i = 0; i < count; i += 32) {
+    uint32_t bits = nextRand();
+    for (uint32_t j = 0; j < 32 && i + j < count; j++) {
+      uint32_t random = (bits >> j) & 1;
+      batch_secrets[i + j] = random ? nextRand() % P : fixed_scalar;
+      classes[(i + j) / 8] |= (uint8_t)(random << ((i + j) % 8));
+    }
+  }
+  batch_capture(count, gap_us, 1);
+  send_bytes(classes, (count + 7) / 8);
+  batch_send(count);
+  return 1;
+}
+
+// use (x, y) as the base point, returns 0 if it is not on the curve. The
+// multiplication table only covers G.
+static int set_base_point(uint32_t x, uint32_t y) {
+  if (x >= P || y >= P) {
+    return 0;
+  }
+  if (mod_mul(y, y) != mod_p(mod_mul(mod_mul(x, x), x) + mod_mul(A, x) + B)) {
+    return 0;
+  }
+  if (TOY_MUL_TABLE && (x != Gx || y != Gy)) {
+    return 0;
+  }
+  base_point.x = x;
+  base_point.y = y;
+  base_point.z = 1;
+  return 1;
+}
+
+// fixed scalar for mul and tvla, below P like the random secrets
+static int set_fixed_scalar(uint32_t k) {
+  if (k >= P) {
+    return 0;
+  }
+  fixed_scalar = k;
+  return 1;
+}
 
-  if (a.x == b.x && a.y == b.y) {
-    lambda = ((3 * a.x * a.x + A) * modinv(2 * a.y, P)) % P;
+// one multiplication of the base point by the fixed scalar, prints x and y
+static void run_mul(void) {
+  batch_secrets[0] = fixed_scalar;
+  batch_capture(1, 0, 1);
+  uint32_t x, y;
+  if (!ec_to_affine(&batch_points[0], &x, &y)) {
+    x = TOY_CURVE_INFINITY;
+    y = TOY_CURVE_INFINITY;
+  }
+  send_value(x);
+  send_value(y);
+}
+
+// cycles to invert every non-zero element with fn, sets *ok to 0 on a wrong
+// inverse
+static uint32_t time_modinv(uint32_t (*fn)(uint32_t), int* ok) {
+  uint32_t cycles = 0;
+  for (uint32_t a = 1; a < P; a++) {
+    uint32_t start = cyccnt_read();
+    uint32_t inv = fn(a);
+    cycles += cyccnt_read() - start;
+    if (mod_mul(a, inv) != 1) {
+      *ok = 0;
+    }
+  }
+  return cycles;
+}
+
+static void bench_modinv(void) {
+  int ok = 1;
+  // 0 Fermat, 1 Euclid, 2 table
+  send_value(TOY_MODINV - TOY_MODINV_FERMAT);
+  uint32_t fermat = time_modinv(modinv_fermat, &ok);
+  uint32_t euclid = time_modinv(modinv_euclid, &ok);
+#if TOY_MODINV == TOY_MODINV_TABLE
+  uint32_t table = time_modinv(modinv_table, &ok);
+#else
+  uint32_t table = 0;
+#endif
+  send_value(ok);
+  send_value(fermat);
+  send_value(euclid);
+  send_value(table);
+}
+
+// min, max and total cycles of one reduction of each product of two random
+// coordinates, with UDIV and with mod_p. The divisor is read through a
+// volatile so the compiler can't turn the % into a multiplication.
+static void bench_reduce(void) {
+  static volatile uint32_t divisor = TOY_CURVE_P;
+  uint32_t div_min = UINT32_MAX, div_max = 0, div_total = 0;
+  uint32_t mul_min = UINT32_MAX, mul_max = 0, mul_total = 0;
+  int ok = 1;
+  for (int i = 0; i < 1000; i++) {
+    uint32_t x = (nextRand() % P) * (nextRand() % P);
+    uint32_t d = divisor;
+
+    uint32_t start = cyccnt_read();
+    uint32_t slow = x % d;
+    uint32_t cycles = cyccnt_read() - start;
+    div_total += cycles;
+    div_min = cycles < div_min ? cycles : div_min;
+    div_max = cycles > div_max ? cycles : div_max;
+
+    start = cyccnt_read();
+    uint32_t fast = mod_p(x);
+    cycles = cyccnt_read() - start;
+    mul_total += cycles;
+    mul_min = cycles < mul_min ? cycles : mul_min;
+    mul_max = cycles > mul_max ? cycles : mul_max;
+
+    ok &= slow == fast;
+  }
+  send_value(ok);
+  send_value(div_min);
+  send_value(div_max);
+  send_value(div_total);
+  send_value(mul_min);
+  send_value(mul_max);
+  send_value(mul_total);
+}
+
+// n chained field multiplications, the kernel of bench_ramfunc. Inlined into
+// one copy linked in flash and one copied to SRAM.
+__attribute__((always_inline)) static inline uint32_t mul_chain(uint32_t x, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    x = mod_p(mod_mul(x, x) + i);
+  }
+  return x;
+}
+
+__attribute__((noinline)) static uint32_t mul_chain_flash(uint32_t x, uint32_t n) {
+  return mul_chain(x, n);
+}
+
+static RAMFUNC uint32_t mul_chain_sram(uint32_t x, uint32_t n) {
+  return mul_chain(x, n);
+}
+
+// prefetch, instruction and data cache of the flash interface (the ART
+// accelerator), the caches are reset while off so no stale line survives
+static void flash_art(int on) {
+  if (on) {
+    __HAL_FLASH_INSTRUCTION_CACHE_RESET();
+    __HAL_FLASH_DATA_CACHE_RESET();
+    __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+    __HAL_FLASH_INSTRUCTION_CACHE_ENABLE();
+    __HAL_FLASH_DATA_CACHE_ENABLE();
   } else {
-    lambda = ((b.y - a.y) * modinv(b.x - a.x, P)) % P;
+    __HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+    __HAL_FLASH_INSTRUCTION_CACHE_DISABLE();
+    __HAL_FLASH_DATA_CACHE_DISABLE();
   }
-  result.x = (lambda * lambda - a.x - b.x) % P;
-  result.y = (lambda * (a.x - result.x) - a.y) % P;
-  return result;
 }
 
-static inline ECPoint ec_mul(uint32_t k, ECPoint p) {
-  ECPoint result = {0, 0};
-  for (int i = 0; i < 32; i++) {
-    if (k & (1 << i)) {
-      result = ec_add(result, p);
+#define RAMFUNC_CHAIN 1000
+
+// cycles of RAMFUNC_CHAIN multiplications from flash without the ART, from
+// flash with the ART and from SRAM, in every clock profile. Nothing is sent
+// until the original profile and baud rate are back.
+static void bench_ramfunc(void) {
+  static uint32_t cycles[CLOCK_PROFILE_COUNT][3];
+  int ok[CLOCK_PROFILE_COUNT];
+  clock_profile_t current = clock_current();
+  uint32_t x = nextRand() % P;
+
+  uart_io_flush();
+  for (clock_profile_t p = 0; p < CLOCK_PROFILE_COUNT; p++) {
+    ok[p] = clock_apply(p);
+
+    flash_art(0);
+    uint32_t start = cyccnt_read();
+    uint32_t plain = mul_chain_flash(x, RAMFUNC_CHAIN);
+    cycles[p][0] = cyccnt_read() - start;
+    flash_art(1);
+
+    // once to fill the caches, then timed
+    mul_chain_flash(x, RAMFUNC_CHAIN);
+    start = cyccnt_read();
+    uint32_t art = mul_chain_flash(x, RAMFUNC_CHAIN);
+    cycles[p][1] = cyccnt_read() - start;
+
+    start = cyccnt_read();
+    uint32_t sram = mul_chain_sram(x, RAMFUNC_CHAIN);
+    cycles[p][2] = cyccnt_read() - start;
+
+    ok[p] &= plain == art && art == sram;
+  }
+  clock_apply(current);
+  uart_io_update_baud();
+
+  send_value(TOY_SRAM);
+  for (clock_profile_t p = 0; p < CLOCK_PROFILE_COUNT; p++) {
+    send_value(ok[p]);
+    send_value(cycles[p][0]);
+    send_value(cycles[p][1]);
+    send_value(cycles[p][2]);
+  }
+}
+
+// an empty line: a random toy curve secret, then x and y of secret * G
+static void run_random_mul(void) {
+  uint32_t secret = nextRand() % P;
+  send_value(secret);
+
+  ECPoint G = {Gx, Gy, 1};
+  ECPoint R;
+  uint32_t x, y;
+  ec_mul(&R, secret, &G);
+  if (!ec_to_affine(&R, &x, &y)) {
+    x = TOY_CURVE_INFINITY;
+    y = TOY_CURVE_INFINITY;
+  }
+  send_value(x);
+  send_value(y);
+}
+
+// binary mode input, returns 1 once a FRAME_COMMAND is complete in rxBuffer
+// with its length in rxIndex, anything else is answered with FRAME_UNKNOWN
+static int receive_frame_byte(uint8_t byte) {
+  uint8_t type;
+  uint32_t len;
+  int status = frame_decoder_push(&frame_decoder, byte, &type, rxBuffer, &len);
+  if (status == 0) {
+    return 0;
+  }
+  response_closed = 0;
+  frame_payload_len = 0;
+  if (status < 0 || type != FRAME_COMMAND) {
+    send_frame(FRAME_UNKNOWN);
+    return 0;
+  }
+  rxIndex = len;
+  return 1;
+}
+
+// text mode input, returns 1 at the end of a line with its length in
+// rxIndex (0 for an empty line)
+static int receive_line_byte(uint8_t byte) {
+  switch (byte) {
+    case '\b': // Backspace
+      if (rxIndex > 0) {
+        rxIndex--;
+      }
+      uint8_t backspace[] = "\b \b";
+      uart_io_write(backspace, sizeof(backspace)-1);
+      return 0;
+    case '\n':
+    case '\r':
+      return 1;
+    default:
+      if (rxIndex < BUFFER_SIZE) {
+        rxBuffer[rxIndex++] = byte;
+      }
+      uart_io_write(&byte, 1);
+      return 0;
+  }
+}
+
+// Scheduler tasks, see Core/Inc/sched.h. The UART interrupt posts
+// task_input, which feeds received bytes to the line editor or the frame
+// decoder until a command is complete and hands it to task_command. Input
+// waits in the DMA ring while the command runs, its output is sent by DMA
+// meanwhile, then task_command posts task_input again.
+static int task_command_id;
+static int task_input_id;
+// rxBuffer holds a command not run yet
+static int command_ready = 0;
+
+static const uint8_t prompt[] = "\r\n>";
+
+static void task_command(void) {
+  HAL_GPIO_WritePin(LD5_GPIO_Port, LD5_Pin, GPIO_PIN_SET); // Turn on the LED
+  if (binary_mode) {
+    if (rxIndex == 0) {
+      run_random_mul();
+    } else {
+      run_command(rxBuffer, rxIndex);
     }
-    HAL_GPIO_WritePin(LD6_GPIO_Port, LD6_Pin, GPIO_PIN_SET); // Turn on the LED
-    p = ec_add(p, p);
-    HAL_GPIO_WritePin(LD6_GPIO_Port, LD6_Pin, GPIO_PIN_RESET); // Turn off the LED
+    if (!response_closed) {
+      send_frame(FRAME_END);
+    }
+    if (!binary_mode) {
+      // a framed "text" command, back to the console
+      uart_io_write(prompt, sizeof(prompt));
+    }
+  } else {
+    if (rxIndex > 0) {
+      run_command(rxBuffer, rxIndex);
+    } else {
+      run_random_mul();
+    }
+    if (binary_mode) {
+      // switched by the binary command, no more prompts
+      frame_decoder_init(&frame_decoder);
+    } else {
+      uart_io_write(prompt, sizeof(prompt));
+    }
+  }
+  rxIndex = 0;
+  command_ready = 0;
+  HAL_GPIO_WritePin(LD5_GPIO_Port, LD5_Pin, GPIO_PIN_RESET); // Turn off the LED
+  sched_post(task_input_id);
+}
+
+static void task_input(void) {
+  uint8_t rxByte;
+  if (command_ready) {
+    return;
+  }
+  HAL_GPIO_WritePin(LD5_GPIO_Port, LD5_Pin, GPIO_PIN_SET); // Turn on the LED
+  while (!command_ready && uart_io_read(&rxByte, 1) == 1) {
+    command_ready = binary_mode ? receive_frame_byte(rxByte) : receive_line_byte(rxByte);
+  }
+  HAL_GPIO_WritePin(LD5_GPIO_Port, LD5_Pin, GPIO_PIN_RESET); // Turn off the LED
+  if (command_ready) {
+    sched_post(task_command_id);
   }
-  return result;
+}
+
+// from the UART reception interrupt
+static void post_input(void) {
+  sched_post(task_input_id);
 }
 
 /* USER CODE END 0 */
@@ -172,79 +1220,50 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+  // SystemClock_Config leaves the HSI running, switch to the build profile
+  // before the peripherals compute their dividers (stays on HSI on failure)
+  clock_apply(CLOCK_PROFILE);
 
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
 
   initRand();
+  cyccnt_init();
+  itm_log_init();
+  trigger_init();
+  uart_io_start(&huart2);
 
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
-  const uint8_t prompt[] = "\r\n>";
-  const uint8_t response[] = "\r\n:";
-  uint8_t ffprint[8];
+  frame_decoder_init(&frame_decoder);
+  sched_init();
+  task_command_id = sched_add(task_command);
+  task_input_id = sched_add(task_input);
+  uart_io_on_receive(post_input);
+  // bytes that arrived before the callback was set
+  sched_post(task_input_id);
 
   while (1)
   {
-    uint8_t rxByte;
-
-    HAL_GPIO_WritePin(LD4_GPIO_Port, LD4_Pin, GPIO_PIN_SET); // Turn on the LED
-    HAL_StatusTypeDef res = HAL_UART_Receive(&huart2, &rxByte, 1, HAL_MAX_DELAY);
-    HAL_GPIO_WritePin(LD4_GPIO_Port, LD4_Pin, GPIO_PIN_RESET); // Turn on the LED
-
-    if (res == HAL_OK) {
-      HAL_GPIO_WritePin(LD5_GPIO_Port, LD5_Pin, GPIO_PIN_SET); // Turn on the LED
-
-      switch (rxByte) {
-        case '\b': // Backspace
-          if (rxIndex > 0) {
-            rxIndex--;
-          }
-          uint8_t backspace[] = "\b \b";
-          HAL_UART_Transmit(&huart2, backspace, sizeof(backspace)-1, HAL_MAX_DELAY);
-          break;
-        case '\n':
-        case '\r':
-          rxIndex = 0;
-          // create a random secret multiplier
-          uint32_t secret = nextRand() % P;
-          to_hex(ffprint, secret);
-          // Clear the current line and move cursor to start
-          HAL_UART_Transmit(&huart2, response, sizeof(response), HAL_MAX_DELAY);
-          // Print the secret for debugging
-          HAL_UART_Transmit(&huart2, ffprint, sizeof(ffprint), HAL_MAX_DELAY);
-
-          ECPoint G = {Gx, Gy};
-          ECPoint R = ec_mul(secret, G);
-
-          to_hex(ffprint, R.x);
-          // Clear the current line and move cursor to start
-          HAL_UART_Transmit(&huart2, response, sizeof(response), HAL_MAX_DELAY);
-          // Print the secret for debugging
-          HAL_UART_Transmit(&huart2, ffprint, sizeof(ffprint), HAL_MAX_DELAY);
-          
-          to_hex(ffprint, R.y);
-          // Clear the current line and move cursor to start
-          HAL_UART_Transmit(&huart2, response, sizeof(response), HAL_MAX_DELAY);
-          // Print the secret for debugging
-          HAL_UART_Transmit(&huart2, ffprint, sizeof(ffprint), HAL_MAX_DELAY);
-
-          // Clear the current line and move cursor to start
-          HAL_UART_Transmit(&huart2, prompt, sizeof(prompt), HAL_MAX_DELAY);
-          break;
-        default:
-          rxBuffer[rxIndex++] = rxByte;
-          HAL_UART_Transmit(&huart2, &rxByte, 1, HAL_MAX_DELAY);
-          break;
-      } 
-
-      HAL_GPIO_WritePin(LD5_GPIO_Port, LD5_Pin, GPIO_PIN_RESET); // Turn off the LED
+    if (sched_run_pending() == 0) {
+      // sleep with interrupts masked between the check and WFI, a post in
+      // that gap leaves its interrupt pending and WFI returns at once
+      HAL_GPIO_WritePin(LD4_GPIO_Port, LD4_Pin, GPIO_PIN_SET); // Turn on the LED
+      while (sched_pending() == 0) {
+        __disable_irq();
+        if (sched_pending() == 0) {
+          __WFI();
+        }
+        __enable_irq();
+      }
+      HAL_GPIO_WritePin(LD4_GPIO_Port, LD4_Pin, GPIO_PIN_RESET); // Turn off the LED
     }
     /* USER CODE END WHILE */
 
@@ -327,6 +1346,25 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Stream5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -0,0 +1,34 @@
+#include "prof.h"
+
+static prof_stats_t table[PROF_REGION_COUNT];
+
+void prof_record(prof_region_t region, uint32_t cycles) {
+  prof_stats_t* stats = &table[region];
+  if (stats->count == 0 || cycles < stats->min) {
+    stats->min = cycles;
+  }
+  if (cycles > stats->max) {
+    stats->max = cycles;
+  }
+  stats->count++;
+  stats->total += cycles;
+  uint32_t bucket = 31 - __builtin_clz(cycles | 1);
+  stats->hist[bucket < PROF_BUCKETS ? bucket : PROF_BUCKETS - 1]++;
+}
+
+void prof_reset(void) {
+  for (uint32_t i = 0; i < PROF_REGION_COUNT; i++) {
+    prof_stats_t* stats = &table[i];
+    stats->count = 0;
+    stats->min = 0;
+    stats->max = 0;
+    stats->total = 0;
+    for (uint32_t b = 0; b < PROF_BUCKETS; b++) {
+      stats->hist[b] = 0;
+    }
+  }
+}
+
+const prof_stats_t* prof_stats(prof_region_t region) {
+  return &table[region];
+}
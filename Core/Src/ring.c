@@ -0,0 +1,59 @@
+#include "ring.h"
+
+// the acquire loads pair with the release stores so the bytes are visible
+// before the index that publishes them
+void ring_init(ring_t* ring, uint8_t* storage, uint32_t size) {
+  ring->data = storage;
+  ring->size = size;
+  ring->head = 0;
+  ring->tail = 0;
+}
+
+uint32_t ring_count(const ring_t* ring) {
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  return head - tail;
+}
+
+uint32_t ring_write(ring_t* ring, const uint8_t* data, uint32_t len) {
+  uint32_t head = ring->head;
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  uint32_t space = ring->size - (head - tail);
+  if (len > space) {
+    len = space;
+  }
+  for (uint32_t i = 0; i < len; i++) {
+    ring->data[(head + i) & (ring->size - 1)] = data[i];
+  }
+  __atomic_store_n(&ring->head, head + len, __ATOMIC_RELEASE);
+  return len;
+}
+
+uint32_t ring_read(ring_t* ring, uint8_t* data, uint32_t len) {
+  uint32_t tail = ring->tail;
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  if (len > head - tail) {
+    len = head - tail;
+  }
+  for (uint32_t i = 0; i < len; i++) {
+    data[i] = ring->data[(tail + i) & (ring->size - 1)];
+  }
+  __atomic_store_n(&ring->tail, tail + len, __ATOMIC_RELEASE);
+  return len;
+}
+
+uint32_t ring_peek(const ring_t* ring, const uint8_t** data) {
+  uint32_t tail = ring->tail;
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  uint32_t offset = tail & (ring->size - 1);
+  uint32_t len = head - tail;
+  if (len > ring->size - offset) {
+    len = ring->size - offset;
+  }
+  *data = ring->data + offset;
+  return len;
+}
+
+void ring_skip(ring_t* ring, uint32_t len) {
+  __atomic_store_n(&ring->tail, ring->tail + len, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,50 @@
+#include <stddef.h>
+#include "sched.h"
+
+static sched_task_t tasks[SCHED_MAX_TASKS];
+static int task_count = 0;
+// written by interrupts, set and cleared with atomic read-modify-writes
+// (LDREX/STREX on the M4) so a post is never lost
+static uint32_t pending = 0;
+
+void sched_init(void) {
+  for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+    tasks[i] = NULL;
+  }
+  task_count = 0;
+  __atomic_store_n(&pending, 0, __ATOMIC_RELEASE);
+}
+
+int sched_add(sched_task_t fn) {
+  if (task_count == SCHED_MAX_TASKS) {
+    return -1;
+  }
+  tasks[task_count] = fn;
+  return task_count++;
+}
+
+void sched_post(int id) {
+  if (id < 0 || id >= task_count) {
+    return;
+  }
+  __atomic_fetch_or(&pending, 1u << id, __ATOMIC_RELEASE);
+}
+
+uint32_t sched_pending(void) {
+  return __atomic_load_n(&pending, __ATOMIC_ACQUIRE);
+}
+
+uint32_t sched_run_pending(void) {
+  uint32_t ran = 0;
+  uint32_t posted;
+  // the highest priority task posted so far, rechecked after each run so a
+  // post from a task or interrupt takes effect immediately
+  while ((posted = sched_pending()) != 0) {
+    int id = __builtin_ctz(posted);
+    // cleared before it runs, a post while it runs schedules it again
+    __atomic_fetch_and(&pending, ~(1u << id), __ATOMIC_ACQ_REL);
+    tasks[id]();
+    ran++;
+  }
+  return ran;
+}
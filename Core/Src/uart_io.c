@@ -0,0 +1,178 @@
+#include "uart_io.h"
+#include "ring.h"
+#include "prof.h"
+
+static UART_HandleTypeDef* uart;
+
+static uint8_t rx_dma[UART_RX_DMA_SIZE];
+static uint8_t rx_storage[UART_RX_RING_SIZE];
+static ring_t rx_ring;
+// first byte of rx_dma not moved to the ring yet
+static uint32_t rx_pos;
+static volatile uint32_t rx_dropped;
+static void (*rx_callback)(void);
+
+static uint8_t tx_storage[UART_TX_RING_SIZE];
+static ring_t tx_ring;
+// length of the DMA transfer in flight, 0 when idle
+static volatile uint32_t tx_busy;
+static volatile uint32_t tx_hold_depth;
+static int tx_trigger_hold;
+static uint32_t tx_dropped;
+
+static void rx_restart(void) {
+  rx_pos = 0;
+  if (HAL_UARTEx_ReceiveToIdle_DMA(uart, rx_dma, sizeof(rx_dma)) != HAL_OK) {
+    Error_Handler();
+  }
+}
+
+void uart_io_start(UART_HandleTypeDef* huart) {
+  uart = huart;
+  ring_init(&rx_ring, rx_storage, sizeof(rx_storage));
+  ring_init(&tx_ring, tx_storage, sizeof(tx_storage));
+  tx_busy = 0;
+  tx_hold_depth = 0;
+  rx_restart();
+}
+
+// USART2 hangs off APB1
+void uart_io_update_baud(void) {
+  uart->Instance->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(), uart->Init.BaudRate);
+}
+
+uint32_t uart_io_read(uint8_t* data, uint32_t len) {
+  return ring_read(&rx_ring, data, len);
+}
+
+void uart_io_on_receive(void (*callback)(void)) {
+  rx_callback = callback;
+}
+
+uint32_t uart_io_rx_dropped(void) {
+  return rx_dropped;
+}
+
+static void rx_push(const uint8_t* data, uint32_t len) {
+  rx_dropped += len - ring_write(&rx_ring, data, len);
+}
+
+// pos is how far the DMA got into rx_dma, it restarts from 0 after reaching
+// the end so a position behind rx_pos means it wrapped
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t pos) {
+  if (huart != uart || pos == rx_pos) {
+    return;
+  }
+  PROF_SCOPE(PROF_UART_RX);
+  if (pos > rx_pos) {
+    rx_push(rx_dma + rx_pos, pos - rx_pos);
+  } else {
+    rx_push(rx_dma + rx_pos, sizeof(rx_dma) - rx_pos);
+    rx_push(rx_dma, pos);
+  }
+  rx_pos = pos == sizeof(rx_dma) ? 0 : pos;
+  if (rx_callback != NULL) {
+    rx_callback();
+  }
+}
+
+// with DMA reception every error (overrun, noise, framing, parity) ends it
+// and aborts the DMA, so start it again. The bytes in rx_dma after rx_pos
+// are lost since no RxEvent is delivered for them
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) {
+  if (huart != uart) {
+    return;
+  }
+  rx_dropped++;
+  if (huart->RxState == HAL_UART_STATE_READY) {
+    rx_restart();
+  }
+}
+
+// start the next transfer unless one is running or they are held, called
+// from the main loop and from the completion interrupt
+static void tx_kick(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (tx_busy == 0 && tx_hold_depth == 0) {
+    const uint8_t* data;
+    uint32_t len = ring_peek(&tx_ring, &data);
+    if (len > UART_TX_CHUNK) {
+      len = UART_TX_CHUNK;
+    }
+    if (len != 0 && HAL_UART_Transmit_DMA(uart, data, len) == HAL_OK) {
+      tx_busy = len;
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+  if (huart != uart) {
+    return;
+  }
+  ring_skip(&tx_ring, tx_busy);
+  tx_busy = 0;
+  tx_kick();
+}
+
+uint32_t uart_io_try_write(const uint8_t* data, uint32_t len) {
+  uint32_t queued = ring_write(&tx_ring, data, len);
+  tx_kick();
+  return queued;
+}
+
+void uart_io_write(const uint8_t* data, uint32_t len) {
+  PROF_SCOPE(PROF_UART_TX);
+  while (1) {
+    uint32_t queued = uart_io_try_write(data, len);
+    data += queued;
+    len -= queued;
+    if (len == 0) {
+      return;
+    }
+    if (tx_hold_depth != 0) {
+      tx_dropped += len;
+      return;
+    }
+    // a completion frees room, at worst the next tick wakes us
+    __WFI();
+  }
+}
+
+void uart_io_flush(void) {
+  while (ring_count(&tx_ring) != 0 && tx_hold_depth == 0) {
+    __WFI();
+  }
+}
+
+uint32_t uart_io_tx_dropped(void) {
+  return tx_dropped;
+}
+
+void uart_io_set_trigger_hold(int enable) {
+  tx_trigger_hold = enable;
+}
+
+int uart_io_trigger_hold(void) {
+  return tx_trigger_hold;
+}
+
+void uart_io_hold_begin(void) {
+  if (!tx_trigger_hold) {
+    return;
+  }
+  tx_hold_depth++;
+  while (tx_busy != 0) {
+    // at most UART_TX_CHUNK bytes left
+  }
+}
+
+void uart_io_hold_end(void) {
+  if (tx_hold_depth == 0) {
+    return;
+  }
+  if (--tx_hold_depth == 0) {
+    tx_kick();
+  }
+}
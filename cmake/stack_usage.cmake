@@ -0,0 +1,40 @@
+# Collect the .su files written by -fstack-usage into one report sorted by
+# frame size, run after the link with
+# cmake -DDIR=<object dir> -DOUTPUT=<report.txt> -P
+
+file(GLOB_RECURSE su_files "${DIR}/*.su")
+
+# each line is file:line:column:function<TAB>bytes<TAB>static|dynamic|bounded,
+# the entries start with the size zero padded to 8 digits so a string sort
+# orders them, the padded copy is cut off before writing
+set(entries "")
+foreach(su ${su_files})
+    file(STRINGS "${su}" lines)
+    foreach(line ${lines})
+        if(line MATCHES "^(.*)\t([0-9]+)\t([a-z,]+)$")
+            set(location "${CMAKE_MATCH_1}")
+            set(bytes "${CMAKE_MATCH_2}")
+            set(kind "${CMAKE_MATCH_3}")
+            string(REGEX REPLACE "^.*/" "" location "${location}")
+            string(LENGTH "${bytes}" digits)
+            math(EXPR pad "8 - ${digits}")
+            string(REPEAT "0" ${pad} zeros)
+            list(APPEND entries "${zeros}${bytes}\t${bytes}\t${kind}\t${location}")
+        endif()
+    endforeach()
+endforeach()
+list(SORT entries ORDER DESCENDING)
+
+set(report "# bytes kind function, largest frames first\n")
+foreach(entry ${entries})
+    string(SUBSTRING "${entry}" 9 -1 entry)
+    string(APPEND report "${entry}\n")
+endforeach()
+file(WRITE "${OUTPUT}" "${report}")
+
+list(LENGTH entries count)
+if(count GREATER 0)
+    list(GET entries 0 largest)
+    string(SUBSTRING "${largest}" 9 -1 largest)
+    message(STATUS "Stack usage of ${count} functions in ${OUTPUT}, largest: ${largest}")
+endif()
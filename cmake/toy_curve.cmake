@@ -0,0 +1,27 @@
+# Helpers shared by the toy curve table generators, included from scripts
+# run with cmake -P
+
+# Read the TOY_CURVE_* defines of toy_curve.h into variables of the same name
+function(toy_curve_read header)
+    foreach(name A B P GX GY N)
+        file(STRINGS "${header}" line REGEX "^#define TOY_CURVE_${name} ")
+        string(REGEX REPLACE "^#define TOY_CURVE_${name} ([0-9]+).*" "\\1" value "${line}")
+        if(NOT value MATCHES "^[0-9]+$")
+            message(FATAL_ERROR "TOY_CURVE_${name} not found in ${header}")
+        endif()
+        set(TOY_CURVE_${name} ${value} PARENT_SCOPE)
+    endforeach()
+endfunction()
+
+# Set inv_<i> to the inverse of i mod TOY_CURVE_P for every i < P, using
+# inv(i) = -(P / i) * inv(P mod i) mod P which only needs entries below i
+macro(toy_curve_inverses)
+    set(inv_0 0)
+    set(inv_1 1)
+    math(EXPR _last "${TOY_CURVE_P} - 1")
+    foreach(_i RANGE 2 ${_last})
+        math(EXPR _q "${TOY_CURVE_P} / ${_i}")
+        math(EXPR _r "${TOY_CURVE_P} % ${_i}")
+        math(EXPR inv_${_i} "(${TOY_CURVE_P} - (${_q} * ${inv_${_r}}) % ${TOY_CURVE_P}) % ${TOY_CURVE_P}")
+    endforeach()
+endmacro()
@@ -0,0 +1,25 @@
+# Generate the modular inverse table of the toy curve field, run at build
+# time with cmake -DCURVE_HEADER=<toy_curve.h> -DOUTPUT=<file.c> -P
+
+include(${CMAKE_CURRENT_LIST_DIR}/toy_curve.cmake)
+toy_curve_read("${CURVE_HEADER}")
+toy_curve_inverses()
+
+set(body " ")
+set(column 0)
+math(EXPR last "${TOY_CURVE_P} - 1")
+foreach(i RANGE 0 ${last})
+    if(column EQUAL 12)
+        string(APPEND body "\n ")
+        set(column 0)
+    endif()
+    string(APPEND body " ${inv_${i}},")
+    math(EXPR column "${column} + 1")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp"
+"// Generated by cmake/toy_inv_table.cmake, do not edit\n\n"
+"#include \"toy_inv_table.h\"\n\n"
+"TOY_RAMDATA const uint16_t inv_table[TOY_CURVE_P] = {\n${body}\n};\n")
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
@@ -0,0 +1,57 @@
+# Generate every multiple k * G of the toy curve generator, run at build
+# time with cmake -DCURVE_HEADER=<toy_curve.h> -DOUTPUT=<file.c> -P
+#
+# Walks G, 2G, ..., (N - 1)G with one affine addition of G per step, the
+# inverses come from the same recurrence as the inverse table.
+
+include(${CMAKE_CURRENT_LIST_DIR}/toy_curve.cmake)
+toy_curve_read("${CURVE_HEADER}")
+toy_curve_inverses()
+set(P ${TOY_CURVE_P})
+
+# entry 0 is the point at infinity, stored as the X = Y = 1 of its Jacobian
+# form, the lookup sets Z = 0 for it
+set(body "  {1, 1},")
+set(x ${TOY_CURVE_GX})
+set(y ${TOY_CURVE_GY})
+set(column 1)
+math(EXPR last "${TOY_CURVE_N} - 1")
+foreach(k RANGE 1 ${last})
+    if(column EQUAL 6)
+        string(APPEND body "\n ")
+        set(column 0)
+    endif()
+    string(APPEND body " {${x}, ${y}},")
+    math(EXPR column "${column} + 1")
+
+    if(k EQUAL last)
+        break()
+    endif()
+    # (x, y) += G, the tangent when (x, y) = G
+    if(x EQUAL TOY_CURVE_GX)
+        if(NOT y EQUAL TOY_CURVE_GY)
+            message(FATAL_ERROR "${k}G = -G, TOY_CURVE_N is not the order of G")
+        endif()
+        math(EXPR num "(3 * ${x} * ${x} + ${TOY_CURVE_A}) % ${P}")
+        math(EXPR den "(2 * ${y}) % ${P}")
+    else()
+        math(EXPR num "(${TOY_CURVE_GY} + ${P} - ${y}) % ${P}")
+        math(EXPR den "(${TOY_CURVE_GX} + ${P} - ${x}) % ${P}")
+    endif()
+    math(EXPR lambda "(${num} * ${inv_${den}}) % ${P}")
+    math(EXPR x3 "(${lambda} * ${lambda} + 2 * ${P} - ${x} - ${TOY_CURVE_GX}) % ${P}")
+    math(EXPR y "(${lambda} * ((${x} + ${P} - ${x3}) % ${P}) + ${P} - ${y}) % ${P}")
+    set(x ${x3})
+endforeach()
+
+# (N - 1)G = -G closes the group
+if(NOT x EQUAL TOY_CURVE_GX)
+    message(FATAL_ERROR "(N - 1)G != -G, TOY_CURVE_N is not the order of G")
+endif()
+
+file(WRITE "${OUTPUT}.tmp"
+"// Generated by cmake/toy_mul_table.cmake, do not edit\n\n"
+"#include \"toy_mul_table.h\"\n\n"
+"TOY_RAMDATA const uint16_t toy_mul_table[TOY_CURVE_N][2] = {\n${body}\n};\n")
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
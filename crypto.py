@@ -7,8 +7,9 @@ class PRNG:
     MASK64 = (1 << 64) - 1
     MASK32 = (1 << 32) - 1
     
-    def __init__(self):
-        self.splitmix64_seed = 0xbad5eed
+    def __init__(self, seed=0xbad5eed):
+        # same as seedRand(seed) on the board
+        self.splitmix64_seed = seed
         self.s = [0] * 4  # xoshiro128+ state
         
         # Initialize the xoshiro128+ state using splitmix64
@@ -0,0 +1,210 @@
+"""
+Synthetic power traces of the toy curve multiplication, from the host
+simulation build (sim/) instead of the scope.
+
+Runs `batch <count> 0 1` on firmware_sim with SIM_OPERANDS set, so every
+intermediate of the toy field arithmetic (products, differences and reduced
+results, see TRACE_OPERAND in Core/Inc/trigger.h) is recorded in program
+order next to the trigger edges. Each of these register writes becomes
+SAMPLES_PER_WRITE samples of a Hamming weight (hw) or Hamming distance to the
+previous write (hd) leakage with Gaussian noise. The traces are written like
+data/capture_trace.py writes a capture, so the data/ scripts load them as
+they are:
+
+- dump_1.bin and preamble_1.json: the power channel
+- dump_2.bin and preamble_2.json: the trigger (PD15), high during every
+  doubling
+- secrets.json: the PRNG seed, the model and secret, x, y of every
+  multiplication, in the order of the windows
+
+    python3 leakage_sim.py build-sim/firmware_sim [count [hw|hd [out_dir [seed]]]]
+
+Without arguments it checks the model on a made up operand trace.
+"""
+
+import json
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+from array import array
+from pathlib import Path
+from typing import Dict, Iterator, List, Tuple
+
+from toy_dlog import ToyDlog, parse_log
+
+# Records of the operand trace, see sim/sim_hal.c
+RECORD = struct.Struct("<II")
+RECORD_OPERAND = 0
+RECORD_PIN = 1
+
+TRIGGER_PIN = 15  # LD6
+
+# 625 MS/s as in data/capture_trace.py with two channels, 1.6 ns per sample
+SAMPLE_RATE = 625e6
+SAMPLES_PER_WRITE = 4
+# the charge of a write fades over its samples
+WRITE_SHAPE = (1.0, 0.6, 0.3, 0.1)
+# quiet samples before the first and after the last record, the scope keeps
+# a pre-trigger part too
+IDLE_SAMPLES = 2000
+
+# volts per bit of leakage, baseline and noise of the power channel
+LEAK_VOLTS = 0.002
+BASELINE_VOLTS = 0.05
+NOISE_VOLTS = 0.004
+TRIGGER_VOLTS = 3.3
+
+# WORD samples, raw 32768 is 0 V on the power channel. The trigger channel
+# has a coarser step and its 0 V lower to fit 3.3 V.
+POWER_YINCREMENT = 1e-5
+TRIGGER_YINCREMENT = 1e-4
+TRIGGER_YORIGIN = -8192.0
+
+
+def records(trace: bytes) -> Iterator[Tuple[int, int]]:
+    """(kind, value) of every record of a SIM_OPERANDS file"""
+    yield from RECORD.iter_unpack(trace[:len(trace) - len(trace) % RECORD.size])
+
+
+def leakage(trace: bytes, model: str) -> Tuple[List[int], List[int]]:
+    """Bits of leakage of every record and the trigger level during it. hw
+    counts the set bits of the value written, hd those that changed from the
+    previous write. A pin edge is a store too, it takes its samples without
+    leakage so windows with no write between them stay apart."""
+    leaks, levels = [], []
+    previous = 0
+    level = 0
+    for kind, value in records(trace):
+        if kind == RECORD_PIN:
+            if value >> 8 == TRIGGER_PIN and value & 0xFF < 2:
+                level = value & 0xFF
+            leaks.append(0)
+        else:
+            leaks.append(bin(value ^ previous if model == "hd" else value).count("1"))
+            previous = value
+        levels.append(level)
+    return leaks, levels
+
+
+def samples(leaks: List[int], levels: List[int], rng: random.Random) -> Tuple[array, array]:
+    """Raw WORD samples of the power and trigger channels, see preamble"""
+    power = array("H")
+    trigger = array("H")
+    zero = 32768
+    low = int(-TRIGGER_YORIGIN)
+    high = low + round(TRIGGER_VOLTS / TRIGGER_YINCREMENT)
+
+    def power_sample(volts: float) -> int:
+        raw = zero + round((volts + rng.gauss(0.0, NOISE_VOLTS)) / POWER_YINCREMENT)
+        return min(max(raw, 0), 0xFFFF)
+
+    for _ in range(IDLE_SAMPLES):
+        power.append(power_sample(BASELINE_VOLTS))
+    trigger.extend([low] * IDLE_SAMPLES)
+    for leak, level in zip(leaks, levels):
+        for weight in WRITE_SHAPE[:SAMPLES_PER_WRITE]:
+            power.append(power_sample(BASELINE_VOLTS + weight * leak * LEAK_VOLTS))
+        trigger.extend([high if level else low] * SAMPLES_PER_WRITE)
+    for _ in range(IDLE_SAMPLES):
+        power.append(power_sample(BASELINE_VOLTS))
+    trigger.extend([low] * IDLE_SAMPLES)
+    return power, trigger
+
+
+def preamble(points: int, yincrement: float, yorigin: float, first_edge: int) -> Dict[str, float]:
+    """The fields of :WAV:PRE? as data/capture_trace.py stores them, time 0
+    at the first trigger edge"""
+    xincrement = 1 / SAMPLE_RATE
+    return {
+        "format": 1.0,
+        "type": 2.0,
+        "points": float(points),
+        "count": 1.0,
+        "xincrement": xincrement,
+        "xorigin": -first_edge * xincrement,
+        "xreference": 0.0,
+        "yincrement": yincrement,
+        "yorigin": yorigin,
+        "yreference": 32768.0,
+    }
+
+
+def windows(trigger: array) -> int:
+    """Rising edges of the trigger channel"""
+    threshold = int(-TRIGGER_YORIGIN) + round(TRIGGER_VOLTS / 2 / TRIGGER_YINCREMENT)
+    high = [s > threshold for s in trigger]
+    return sum(1 for a, b in zip(high, high[1:]) if b and not a)
+
+
+def write_capture(out: Path, power: array, trigger: array) -> None:
+    if sys.byteorder != "little":
+        power.byteswap()
+        trigger.byteswap()
+    threshold = int(-TRIGGER_YORIGIN) + round(TRIGGER_VOLTS / 2 / TRIGGER_YINCREMENT)
+    first_edge = next((i for i, s in enumerate(trigger) if s > threshold), 0)
+    channels = ((power, POWER_YINCREMENT, -32768.0), (trigger, TRIGGER_YINCREMENT, TRIGGER_YORIGIN))
+    for chan, (data, yincrement, yorigin) in enumerate(channels, 1):
+        with open(out / f"dump_{chan}.bin", "wb") as f:
+            data.tofile(f)
+        with open(out / f"preamble_{chan}.json", "w") as f:
+            json.dump(preamble(len(data), yincrement, yorigin, first_edge), f, indent=4)
+
+
+def simulate(sim: str, count: int, seed: int) -> Tuple[bytes, List[Tuple[int, int, int]]]:
+    """Operand trace and secret, x, y of count multiplications on firmware_sim"""
+    env = dict(os.environ)
+    env.pop("SIM_UART", None)
+    env.pop("SIM_TRIGGER", None)
+    with tempfile.TemporaryDirectory() as tmp:
+        env["SIM_OPERANDS"] = str(Path(tmp) / "operands.bin")
+        output = subprocess.run([sim], input=f"seed {seed:016x}\rbatch {count} 0 1\r".encode(),
+                                stdout=subprocess.PIPE, env=env, timeout=600, check=True).stdout
+        trace = Path(env["SIM_OPERANDS"]).read_bytes()
+    # after the ok flag of seed
+    return trace, parse_log(output[output.index(b"batch"):].decode(errors="replace"))
+
+
+def main(sim: str, count: int, model: str, out: Path, seed: int) -> int:
+    out.mkdir(parents=True, exist_ok=True)
+    trace, results = simulate(sim, count, seed)
+    assert len(results) == count, f"{len(results)} results for {count} multiplications"
+    dlog = ToyDlog()
+    for secret, x, y in results:
+        assert dlog.check(secret, x, y), f"({x:#x}, {y:#x}) is not {secret:#x} * G"
+
+    leaks, levels = leakage(trace, model)
+    power, trigger = samples(leaks, levels, random.Random(seed))
+    found = windows(trigger)
+    assert found == 32 * count, f"{found} trigger windows for {count} multiplications"
+    write_capture(out, power, trigger)
+    with open(out / "secrets.json", "w") as f:
+        json.dump({"seed": seed, "model": model,
+                   "results": [{"secret": k, "x": x, "y": y} for k, x, y in results]}, f, indent=4)
+    print(f"{count} multiplications, {len(leaks)} records, {len(power)} samples in {out}")
+    return 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        # self check: two writes inside a window, one after it
+        made_up = b"".join(RECORD.pack(*r) for r in [
+            (RECORD_OPERAND, 0xFF), (RECORD_PIN, TRIGGER_PIN << 8 | 2),
+            (RECORD_PIN, TRIGGER_PIN << 8 | 1), (RECORD_OPERAND, 0x0F), (RECORD_OPERAND, 0xF0),
+            (RECORD_PIN, TRIGGER_PIN << 8 | 0), (RECORD_PIN, 13 << 8 | 1), (RECORD_OPERAND, 0xF1),
+        ])
+        assert leakage(made_up, "hw") == ([8, 0, 0, 4, 4, 0, 0, 5], [0, 0, 1, 1, 1, 0, 0, 0])
+        assert leakage(made_up, "hd") == ([8, 0, 0, 4, 8, 0, 0, 1], [0, 0, 1, 1, 1, 0, 0, 0])
+        power, trigger = samples(*leakage(made_up, "hd"), random.Random(1))
+        assert len(power) == len(trigger) == 2 * IDLE_SAMPLES + 8 * SAMPLES_PER_WRITE
+        assert windows(trigger) == 1
+        print(__doc__)
+        sys.exit(0)
+
+    sys.exit(main(sys.argv[1],
+                  int(sys.argv[2]) if len(sys.argv) > 2 else 16,
+                  sys.argv[3] if len(sys.argv) > 3 else "hd",
+                  Path(sys.argv[4]) if len(sys.argv) > 4 else Path("."),
+                  int(sys.argv[5], 16) if len(sys.argv) > 5 else random.getrandbits(64)))
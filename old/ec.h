@@ -3,204 +3,882 @@
 #include <stdint.h>
 #include "ff.h"
 #include "prng.h"
+#include "arena.h"
+#include "toy_curve.h"
 
-// Structure to represent a point on the curve
+// Affine point on the curve. Always a finite point, the point at infinity
+// only exists in Jacobian form (Z = 0) and functions that may produce it
+// return 0 instead of an affine result.
 typedef struct {
     ff_t x;
     ff_t y;
-    int is_infinity;  // 1 if point is O (point at infinity), 0 otherwise
 } ECPoint;
 
+// Point in Jacobian coordinates, (X, Y, Z) represents (X/Z^2, Y/Z^3).
+// Used inside the scalar multiplication to avoid an inversion per step,
+// Z = 0 is the point at infinity.
+typedef struct {
+    ff_t x;
+    ff_t y;
+    ff_t z;
+} ECPointJ;
 
-// the curve is y^2 = x^3 + ax + b mod p
-
-// raw: 0xffffffff00000001000000000000000000000000ffffffffffffffffffffffff
-const ff_t p = { .words = { 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff } };
-// raw: 0xffffffff00000001000000000000000000000000fffffffffffffffffffffffc
-const ff_t a = { .words = { 0xfffffffc, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff } };
-// raw: 0x5ac635d8aa3a93e7b3ebbd55769886bc651d06b0cc53b0f63bce3c3e27d2604b
-const ff_t b = { .words = { 0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0, 0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8 } };
-
-// generator point coordinates
-// raw: 0x6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296
-const ff_t gx = { .words = { 0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81, 0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2 } };
-// raw: 0x4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5
-const ff_t gy = { .words = { 0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357, 0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2 } };
-// the generator point
-const ECPoint g = { .x = gx, .y = gy, .is_infinity = 0 };
-
-// generator order
-// raw: 0xffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551
-const ff_t n = { .words = { 0xfc632551, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff } };
-
-// Extended Euclidean Algorithm for modular inverse
-static inline void ff_mod_inv(ff_t* result, const ff_t* a) {
-    // Handle zero input
-    if (ff_is_zero(a)) {
-        ff_zero(result);
-        return;
+// Domain parameters of a curve y^2 = x^3 + ax + b mod p
+typedef struct {
+    const char* name;
+    ff_t p;
+    ff_t a;
+    ff_t b;
+    ff_t gx;        // generator point coordinates
+    ff_t gy;
+    ff_t n;         // generator order
+} ec_params_t;
+
+// NIST P-256
+static const ec_params_t ec_params_p256 = {
+    .name = "p256",
+    // raw: 0xffffffff00000001000000000000000000000000ffffffffffffffffffffffff
+    .p = { .words = { 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff } },
+    // raw: 0xffffffff00000001000000000000000000000000fffffffffffffffffffffffc
+    .a = { .words = { 0xfffffffc, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff } },
+    // raw: 0x5ac635d8aa3a93e7b3ebbd55769886bc651d06b0cc53b0f63bce3c3e27d2604b
+    .b = { .words = { 0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0, 0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8 } },
+    // raw: 0x6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296
+    .gx = { .words = { 0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81, 0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2 } },
+    // raw: 0x4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5
+    .gy = { .words = { 0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357, 0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2 } },
+    // raw: 0xffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551
+    .n = { .words = { 0xfc632551, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff } },
+};
+
+// secp256k1, a = 0
+static const ec_params_t ec_params_secp256k1 = {
+    .name = "secp256k1",
+    // raw: 0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f
+    .p = { .words = { 0xfffffc2f, 0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff } },
+    .a = { .words = { 0 } },
+    .b = { .words = { 7 } },
+    // raw: 0x79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798
+    .gx = { .words = { 0x16f81798, 0x59f2815b, 0x2dce28d9, 0x029bfcdb, 0xce870b07, 0x55a06295, 0xf9dcbbac, 0x79be667e } },
+    // raw: 0x483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8
+    .gy = { .words = { 0xfb10d4b8, 0x9c47d08f, 0xa6855419, 0xfd17b448, 0x0e1108a8, 0x5da4fbfc, 0x26a3c465, 0x483ada77 } },
+    // raw: 0xfffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141
+    .n = { .words = { 0xd0364141, 0xbfd25e8c, 0xaf48a03b, 0xbaaedce6, 0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff } },
+};
+
+// The 14-bit demo curve from main.c, its order is not prime so it is only
+// good for scalar multiplication, not for ECDSA
+static const ec_params_t ec_params_toy = {
+    .name = "toy",
+    .p = { .words = { TOY_CURVE_P } },
+    .a = { .words = { TOY_CURVE_A } },
+    .b = { .words = { TOY_CURVE_B } },
+    .gx = { .words = { TOY_CURVE_GX } },
+    .gy = { .words = { TOY_CURVE_GY } },
+    .n = { .words = { TOY_CURVE_N } },
+};
+
+// Fixed-base comb (Lim-Lee) with 4 teeth spaced 64 bits apart, entry i is
+// the sum of 2^(64 j) G over the bits j set in i
+#define EC_COMB_TEETH 4
+#define EC_COMB_SPACING (FF_SIZE / EC_COMB_TEETH)
+#define EC_COMB_ENTRIES (1 << EC_COMB_TEETH)
+
+// A curve with everything derived from its parameters precomputed once by
+// ec_curve_init, passed to every point operation
+typedef struct ec_curve {
+    const char* name;
+    ff_modulus_t p;             // field prime and its reduction
+    ff_modulus_t n;             // group order and its reduction
+    ff_t a;
+    ff_t b;
+    ECPoint g;
+    int a_is_minus_3;           // doubling uses dbl-2001-b
+    int a_is_zero;              // doubling skips the a * Z^4 term
+    int p_is_3_mod_4;           // square roots are a single exponentiation
+    ff_t p_plus_1_div_4;
+    ECPoint g_comb[EC_COMB_ENTRIES];
+} ec_curve_t;
+
+// Fast reduction modulo the P-256 prime (FIPS 186-4 D.2.3).
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1 so the high half of the product can be
+// folded back with a handful of word additions instead of a long division.
+static inline void ff_p256_reduce(ff_t* result, const ff_wide_t* t, const ff_t* p) {
+    const uint32_t* c = t->words;
+    int64_t acc[FF_WORDS];
+
+    acc[0] = (int64_t)c[0] + c[8] + c[9] - c[11] - c[12] - c[13] - c[14];
+    acc[1] = (int64_t)c[1] + c[9] + c[10] - c[12] - c[13] - c[14] - c[15];
+    acc[2] = (int64_t)c[2] + c[10] + c[11] - c[13] - c[14] - c[15];
+    acc[3] = (int64_t)c[3] + 2 * (int64_t)c[11] + 2 * (int64_t)c[12] + c[13] - c[15] - c[8] - c[9];
+    acc[4] = (int64_t)c[4] + 2 * (int64_t)c[12] + 2 * (int64_t)c[13] + c[14] - c[9] - c[10];
+    acc[5] = (int64_t)c[5] + 2 * (int64_t)c[13] + 2 * (int64_t)c[14] + c[15] - c[10] - c[11];
+    acc[6] = (int64_t)c[6] + 3 * (int64_t)c[14] + 2 * (int64_t)c[15] + c[13] - c[8] - c[9];
+    acc[7] = (int64_t)c[7] + 3 * (int64_t)c[15] + c[8] - c[10] - c[11] - c[12] - c[13];
+
+    // Propagate the signed carries, what is left on top is a small multiple
+    // of 2^256 that we remove by adding or subtracting p a few times
+    int64_t carry = 0;
+    for (int i = 0; i < FF_WORDS; i++) {
+        carry += acc[i];
+        result->words[i] = (uint32_t)carry;
+        carry >>= 32;
     }
 
-    ff_t reduced_a;
-    ff_mod(&reduced_a, a, &p);  // Reduce input modulo p first
-    
-    ff_t r, old_r;
-    ff_t s, old_s;
-    ff_t t, old_t;
-    ff_t quotient, remainder, temp;
-    
-    // Initialize values
-    r = p;
-    old_r = reduced_a;  // Use reduced input
-    ff_from_u32(&s, 0);
-    ff_from_u32(&old_s, 1);
-    ff_from_u32(&t, 1);
-    ff_from_u32(&old_t, 0);
-    
-    while (!ff_is_zero(&r)) {
-        ff_t temp_r = r;
-        ff_t temp_s = s;
-        ff_t temp_t = t;
-        
-        ff_div(&quotient, &remainder, &old_r, &r);
-        
-        r = remainder;
-        old_r = temp_r;
-        
-        ff_mul(&temp, &quotient, &s);
-        ff_sub(&s, &old_s, &temp);
-        old_s = temp_s;
-        
-        ff_mul(&temp, &quotient, &t);
-        ff_sub(&t, &old_t, &temp);
-        old_t = temp_t;
-    }
-    
-    while (ff_is_negative(&old_s)) {
-        ff_add(&old_s, &old_s, &p);
-    }
-    
-    while (ff_cmp(&old_s, &p) >= 0) {
-        ff_sub(&old_s, &old_s, &p);
-    }
-    
-    ff_mul(&temp, &reduced_a, &old_s);
-    ff_mod(&temp, &temp, &p);
-    ff_t one;
-    ff_from_u32(&one, 1);
-    
-    if (!ff_eq(&temp, &one)) {
-        ff_zero(result);
-        return;
+    int32_t top = (int32_t)carry;
+    while (top < 0) {
+        top += ff_add(result, result, p);
+    }
+    while (top > 0 || ff_cmp(result, p) >= 0) {
+        top -= ff_sub(result, result, p);
+    }
+}
+
+// Reduction modulo the secp256k1 prime, p = 2^256 - c with c = 2^32 + 977,
+// so the high half folds back as hi * 2^32 + hi * 977, twice
+static inline void ff_secp256k1_reduce(ff_t* result, const ff_wide_t* t, const ff_t* p) {
+    const uint32_t* lo = t->words;
+    const uint32_t* hi = t->words + FF_WORDS;
+
+    uint64_t acc = 0;
+    for (int i = 0; i < FF_WORDS; i++) {
+        acc += (uint64_t)lo[i] + (uint64_t)hi[i] * 977 + (i > 0 ? hi[i - 1] : 0);
+        result->words[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    uint64_t top = acc + hi[FF_LAST_WORD];
+
+    // top < 2^34, fold it once more
+    acc = (uint64_t)result->words[0] + (top & 0xffffffff) * 977;
+    result->words[0] = (uint32_t)acc;
+    acc >>= 32;
+    acc += (uint64_t)result->words[1] + top + (top >> 32) * 977;
+    result->words[1] = (uint32_t)acc;
+    acc >>= 32;
+    for (int i = 2; i < FF_WORDS && acc != 0; i++) {
+        acc += result->words[i];
+        result->words[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+
+    // A carry out of 2^256 is worth another c, the sum is tiny by now
+    if (acc) {
+        ff_t c;
+        ff_from_u32(&c, 977);
+        c.words[1] = 1;
+        ff_add(result, result, &c);
+    }
+    if (ff_cmp(result, p) >= 0) {
+        ff_sub(result, result, p);
+    }
+}
+
+static inline void ec_p256_mul(const ff_modulus_t* mod, ff_t* result, const ff_t* a, const ff_t* b) {
+    ff_wide_t product;
+    ff_mul_wide(&product, a, b);
+    ff_p256_reduce(result, &product, &mod->m);
+}
+
+static inline void ec_secp256k1_mul(const ff_modulus_t* mod, ff_t* result, const ff_t* a, const ff_t* b) {
+    ff_wide_t product;
+    ff_mul_wide(&product, a, b);
+    ff_secp256k1_reduce(result, &product, &mod->m);
+}
+
+// Field arithmetic modulo p, inputs must be reduced
+
+static inline void fp_mul(const ec_curve_t* curve, ff_t* result, const ff_t* a, const ff_t* b) {
+    curve->p.mul(&curve->p, result, a, b);
+}
+
+static inline void fp_sqr(const ec_curve_t* curve, ff_t* result, const ff_t* a) {
+    curve->p.mul(&curve->p, result, a, a);
+}
+
+static inline void fp_add(const ec_curve_t* curve, ff_t* result, const ff_t* a, const ff_t* b) {
+    ff_modulus_add(&curve->p, result, a, b);
+}
+
+static inline void fp_sub(const ec_curve_t* curve, ff_t* result, const ff_t* a, const ff_t* b) {
+    ff_modulus_sub(&curve->p, result, a, b);
+}
+
+// Returns zero for a zero input
+static inline void fp_inv(const ec_curve_t* curve, ff_t* result, const ff_t* a) {
+    ff_modulus_inv(&curve->p, result, a);
+}
+
+// Square root modulo p, returns 1 and sets result if a is a quadratic residue.
+// Only p = 3 mod 4 is supported, which covers every curve defined here.
+static inline int fp_sqrt(const ec_curve_t* curve, ff_t* result, const ff_t* a) {
+    if (!curve->p_is_3_mod_4) {
+        return 0;
+    }
+    ff_t root, check;
+    ff_modulus_pow(&curve->p, &root, a, &curve->p_plus_1_div_4);
+    fp_sqr(curve, &check, &root);
+    if (!ff_eq(&check, a)) {
+        return 0;
+    }
+    *result = root;
+    return 1;
+}
+
+// Scalar arithmetic modulo the group order n, used by ECDSA
+
+static inline void fn_mul(const ec_curve_t* curve, ff_t* result, const ff_t* a, const ff_t* b) {
+    curve->n.mul(&curve->n, result, a, b);
+}
+
+static inline void fn_add(const ec_curve_t* curve, ff_t* result, const ff_t* a, const ff_t* b) {
+    ff_modulus_add(&curve->n, result, a, b);
+}
+
+// Reduce any 256-bit value mod n
+static inline void fn_reduce(const ec_curve_t* curve, ff_t* result, const ff_t* a) {
+    ff_modulus_reduce(&curve->n, result, a);
+}
+
+static inline void fn_inv(const ec_curve_t* curve, ff_t* result, const ff_t* a) {
+    ff_modulus_inv(&curve->n, result, a);
+}
+
+static inline void ec_init_random_k(const ec_curve_t* curve, ff_t *result) {
+    ff_t temp;
+    for (int i = 0; i < FF_WORDS; i++) {
+        temp.words[i] = nextRand();
     }
-    
-    *result = old_s;
+    fn_reduce(curve, result, &temp);
 }
 
 // Initialize a point
 static inline void ec_init_point(ECPoint* P, const ff_t* x, const ff_t* y) {
     P->x = *x;
     P->y = *y;
-    P->is_infinity = 0;
 }
 
-// Set point to infinity
-static inline void ec_set_infinity(ECPoint* P) {
-    ff_zero(&P->x);
-    ff_zero(&P->y);
-    P->is_infinity = 1;
+static inline void ec_set_infinity_j(ECPointJ* P) {
+    ff_from_u32(&P->x, 1);
+    ff_from_u32(&P->y, 1);
+    ff_zero(&P->z);
+}
+
+static inline int ec_is_infinity_j(const ECPointJ* P) {
+    return ff_is_zero(&P->z);
+}
+
+static inline void ec_to_jacobian(ECPointJ* result, const ECPoint* P) {
+    result->x = P->x;
+    result->y = P->y;
+    ff_from_u32(&result->z, 1);
 }
-// Add two points on the curve
-static inline void ec_add(ECPoint* result, const ECPoint* P1, const ECPoint* P2) {
-    if (P1->is_infinity) {
-        *result = *P2;
+
+// Convert back to affine, costs one inversion. Returns 0 and leaves
+// result untouched for the point at infinity.
+static inline int ec_to_affine(const ec_curve_t* curve, ECPoint* result, const ECPointJ* P) {
+    if (ec_is_infinity_j(P)) {
+        return 0;
+    }
+    ff_t zinv, zinv2;
+    fp_inv(curve, &zinv, &P->z);
+    fp_sqr(curve, &zinv2, &zinv);
+    fp_mul(curve, &result->x, &P->x, &zinv2);
+    fp_mul(curve, &zinv2, &zinv2, &zinv);
+    fp_mul(curve, &result->y, &P->y, &zinv2);
+    return 1;
+}
+
+// R = 2R in Jacobian coordinates, dbl-2001-b when a = -3 and dbl-2007-bl
+// otherwise. Both give Z3 = 2YZ, so the point at infinity and the points of
+// order two come out with Z = 0 without a special case.
+static inline void ec_double_inplace(const ec_curve_t* curve, ECPointJ* R) {
+    ff_t t1, t2;
+
+    if (curve->a_is_minus_3) {
+        ff_t delta, gamma, beta, alpha;
+
+        fp_sqr(curve, &delta, &R->z);           // delta = Z^2
+        fp_sqr(curve, &gamma, &R->y);           // gamma = Y^2
+        fp_mul(curve, &beta, &R->x, &gamma);    // beta = X * gamma
+
+        // alpha = 3 * (X - delta) * (X + delta)
+        fp_sub(curve, &t1, &R->x, &delta);
+        fp_add(curve, &t2, &R->x, &delta);
+        fp_mul(curve, &alpha, &t1, &t2);
+        fp_add(curve, &t1, &alpha, &alpha);
+        fp_add(curve, &alpha, &t1, &alpha);
+
+        // Z3 = (Y + Z)^2 - gamma - delta, Z is not needed after this
+        fp_add(curve, &t1, &R->y, &R->z);
+        fp_sqr(curve, &t1, &t1);
+        fp_sub(curve, &t1, &t1, &gamma);
+        fp_sub(curve, &R->z, &t1, &delta);
+
+        // X3 = alpha^2 - 8 * beta
+        fp_add(curve, &beta, &beta, &beta);     // 2 beta
+        fp_add(curve, &beta, &beta, &beta);     // 4 beta
+        fp_sqr(curve, &t1, &alpha);
+        fp_sub(curve, &t1, &t1, &beta);
+        fp_sub(curve, &R->x, &t1, &beta);
+
+        // Y3 = alpha * (4 * beta - X3) - 8 * gamma^2
+        fp_sub(curve, &t1, &beta, &R->x);
+        fp_mul(curve, &t1, &alpha, &t1);
+        fp_sqr(curve, &gamma, &gamma);
+        fp_add(curve, &gamma, &gamma, &gamma);  // 2 gamma^2
+        fp_add(curve, &gamma, &gamma, &gamma);  // 4 gamma^2
+        fp_add(curve, &gamma, &gamma, &gamma);  // 8 gamma^2
+        fp_sub(curve, &R->y, &t1, &gamma);
         return;
     }
-    if (P2->is_infinity) {
-        *result = *P1;
+
+    ff_t xx, yy, yyyy, zz, s, m;
+
+    fp_sqr(curve, &xx, &R->x);                  // XX = X^2
+    fp_sqr(curve, &yy, &R->y);                  // YY = Y^2
+    fp_sqr(curve, &yyyy, &yy);                  // YYYY = YY^2
+    fp_sqr(curve, &zz, &R->z);                  // ZZ = Z^2
+
+    // S = 2 * ((X + YY)^2 - XX - YYYY)
+    fp_add(curve, &t1, &R->x, &yy);
+    fp_sqr(curve, &t1, &t1);
+    fp_sub(curve, &t1, &t1, &xx);
+    fp_sub(curve, &t1, &t1, &yyyy);
+    fp_add(curve, &s, &t1, &t1);
+
+    // M = 3 * XX + a * ZZ^2
+    fp_add(curve, &m, &xx, &xx);
+    fp_add(curve, &m, &m, &xx);
+    if (!curve->a_is_zero) {
+        fp_sqr(curve, &t1, &zz);
+        fp_mul(curve, &t1, &t1, &curve->a);
+        fp_add(curve, &m, &m, &t1);
+    }
+
+    // Z3 = (Y + Z)^2 - YY - ZZ, Z is not needed after this
+    fp_add(curve, &t1, &R->y, &R->z);
+    fp_sqr(curve, &t1, &t1);
+    fp_sub(curve, &t1, &t1, &yy);
+    fp_sub(curve, &R->z, &t1, &zz);
+
+    // X3 = M^2 - 2 * S
+    fp_sqr(curve, &t1, &m);
+    fp_sub(curve, &t1, &t1, &s);
+    fp_sub(curve, &R->x, &t1, &s);
+
+    // Y3 = M * (S - X3) - 8 * YYYY
+    fp_sub(curve, &t1, &s, &R->x);
+    fp_mul(curve, &t1, &m, &t1);
+    fp_add(curve, &t2, &yyyy, &yyyy);           // 2 YYYY
+    fp_add(curve, &t2, &t2, &t2);               // 4 YYYY
+    fp_add(curve, &t2, &t2, &t2);               // 8 YYYY
+    fp_sub(curve, &R->y, &t1, &t2);
+}
+
+// R += (x, y) for an affine point given by its coordinates (madd-2007-bl),
+// lets callers add -Q without copying Q
+static inline void ec_add_xy_inplace(const ec_curve_t* curve, ECPointJ* R, const ff_t* x, const ff_t* y) {
+    if (ec_is_infinity_j(R)) {
+        R->x = *x;
+        R->y = *y;
+        ff_from_u32(&R->z, 1);
         return;
     }
-    
-    ff_t neg_y;
-    ff_sub(&neg_y, &p, &P2->y);
-    if (ff_eq(&P1->x, &P2->x) && ff_eq(&P1->y, &neg_y)) {
-        ec_set_infinity(result);
+
+    ff_t z1z1, u2, s2, h, hh, i, j, r, v, t1;
+
+    fp_sqr(curve, &z1z1, &R->z);                // Z1Z1 = Z1^2
+    fp_mul(curve, &u2, x, &z1z1);               // U2 = X2 * Z1Z1
+    fp_mul(curve, &s2, y, &R->z);
+    fp_mul(curve, &s2, &s2, &z1z1);             // S2 = Y2 * Z1 * Z1Z1
+    fp_sub(curve, &h, &u2, &R->x);              // H = U2 - X1
+    fp_sub(curve, &r, &s2, &R->y);
+    fp_add(curve, &r, &r, &r);                  // r = 2 * (S2 - Y1)
+
+    if (ff_is_zero(&h)) {
+        if (ff_is_zero(&r)) {
+            ec_double_inplace(curve, R);
+        } else {
+            ec_set_infinity_j(R);
+        }
         return;
     }
-    
-    ff_t m;
-    
-    if (ff_eq(&P1->x, &P2->x) && ff_eq(&P1->y, &P2->y)) {
-        // Point doubling: m = (3x^2 + a)/(2y)
-        ff_t num, denom, temp;
-        
-        // Calculate numerator: 3x^2 + a
-        ff_mul(&temp, &P1->x, &P1->x);  // x^2
-        ff_mod(&temp, &temp, &p);       // Reduce mod p
-        ff_from_u32(&num, 3);
-        ff_mod_mul(&num, &num, &temp, &p);  // 3x^2
-        ff_mod_add(&num, &num, &a, &p);     // 3x^2 + a
-
-        // Calculate denominator: 2y
-        ff_from_u32(&denom, 2);
-        ff_mod_mul(&denom, &denom, &P1->y, &p);  // 2y
-        
-        // Calculate slope m = (3x^2 + a)/(2y)
-        ff_mod_inv(&temp, &denom);         // Modular inverse of 2y
-        ff_mod_mul(&m, &num, &temp, &p);   // Multiply by numerator 
+
+    fp_sqr(curve, &hh, &h);                     // HH = H^2
+    fp_add(curve, &i, &hh, &hh);
+    fp_add(curve, &i, &i, &i);                  // I = 4 * HH
+    fp_mul(curve, &j, &h, &i);                  // J = H * I
+    fp_mul(curve, &v, &R->x, &i);               // V = X1 * I
+
+    // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+    fp_add(curve, &t1, &R->z, &h);
+    fp_sqr(curve, &t1, &t1);
+    fp_sub(curve, &t1, &t1, &z1z1);
+    fp_sub(curve, &R->z, &t1, &hh);
+
+    // Y1 * J is needed for Y3, keep it before Y1 is overwritten
+    fp_mul(curve, &s2, &R->y, &j);
+    fp_add(curve, &s2, &s2, &s2);               // 2 * Y1 * J
+
+    // X3 = r^2 - J - 2 * V
+    fp_sqr(curve, &t1, &r);
+    fp_sub(curve, &t1, &t1, &j);
+    fp_sub(curve, &t1, &t1, &v);
+    fp_sub(curve, &R->x, &t1, &v);
+
+    // Y3 = r * (V - X3) - 2 * Y1 * J
+    fp_sub(curve, &t1, &v, &R->x);
+    fp_mul(curve, &t1, &r, &t1);
+    fp_sub(curve, &R->y, &t1, &s2);
+}
+
+// R += Q, mixed Jacobian plus affine addition
+static inline void ec_add_inplace(const ec_curve_t* curve, ECPointJ* R, const ECPoint* Q) {
+    ec_add_xy_inplace(curve, R, &Q->x, &Q->y);
+}
+
+// Add two affine points, returns 0 if the sum is the point at infinity.
+// result may alias either input.
+static inline int ec_add(const ec_curve_t* curve, ECPoint* result, const ECPoint* P1, const ECPoint* P2) {
+    ECPointJ R;
+    ec_to_jacobian(&R, P1);
+    ec_add_inplace(curve, &R, P2);
+    return ec_to_affine(curve, result, &R);
+}
+
+// Convert n Jacobian points to affine with a single inversion (Montgomery's
+// simultaneous inversion): invert the product of all Z, then peel off one
+// inverse per point with two multiplications. Points at infinity have no
+// affine form, their entries are zeroed and must not be used: bit i of the
+// returned mask is set when in[i] is one (for i < 32). out holds the running
+// products while they are needed, so it must not alias in.
+static inline uint32_t ec_batch_to_affine(const ec_curve_t* curve, ECPoint* out, const ECPointJ* in, int n) {
+    uint32_t infinite = 0;
+    ff_t acc;
+    ff_from_u32(&acc, 1);
+    for (int i = 0; i < n; i++) {
+        if (!ec_is_infinity_j(&in[i])) {
+            fp_mul(curve, &acc, &acc, &in[i].z);
+        }
+        out[i].x = acc;     // Z_0 * ... * Z_i
+    }
+
+    ff_t inv, zinv, zinv2;
+    fp_inv(curve, &inv, &acc);
+    for (int i = n - 1; i >= 0; i--) {
+        if (ec_is_infinity_j(&in[i])) {
+            ff_zero(&out[i].x);
+            ff_zero(&out[i].y);
+            if (i < 32) {
+                infinite |= 1u << i;
+            }
+            continue;
+        }
+        // inv = (Z_0 * ... * Z_i)^-1, so Z_i^-1 = inv * Z_0 * ... * Z_(i-1)
+        if (i > 0) {
+            fp_mul(curve, &zinv, &inv, &out[i - 1].x);
+            fp_mul(curve, &inv, &inv, &in[i].z);
+        } else {
+            zinv = inv;
+        }
+        fp_sqr(curve, &zinv2, &zinv);
+        fp_mul(curve, &out[i].x, &in[i].x, &zinv2);
+        fp_mul(curve, &zinv2, &zinv2, &zinv);
+        fp_mul(curve, &out[i].y, &in[i].y, &zinv2);
+    }
+    return infinite;
+}
+
+static inline void ec_negate(const ec_curve_t* curve, ECPoint* result, const ECPoint* P) {
+    result->x = P->x;
+    fp_sub(curve, &result->y, &curve->p.m, &P->y);
+}
+
+// Width-w NAF: every digit is zero or odd in (-2^(w-1), 2^(w-1)) and any w
+// consecutive digits hold at most one non-zero, so a scalar multiplication
+// needs about FF_SIZE / (w + 1) additions from a table of 2^(w-2) points
+#define EC_WNAF_WIDTH 4
+#define EC_WNAF_ENTRIES (1 << (EC_WNAF_WIDTH - 2))
+#define EC_WNAF_MAX_POINTS 2
+// Scalars may be one word longer than an ff_t, see ec_scalar_mul_blinded
+#define EC_SCALAR_MAX_WORDS (FF_WORDS + 1)
+#define EC_WNAF_MAX_DIGITS (32 * EC_SCALAR_MAX_WORDS + 1)
+
+// ec_comb_init is the largest user of scratch_arena and nothing holds
+// scratch while it runs, so the allocations can't fail if this fits
+typedef char ec_scratch_fits[
+    EC_COMB_ENTRIES * (sizeof(ECPointJ) + sizeof(ECPoint) + sizeof(int)) <= SCRATCH_ARENA_SIZE &&
+    EC_WNAF_MAX_POINTS * (EC_WNAF_ENTRIES * sizeof(ECPointJ) + sizeof(ECPoint)) <= SCRATCH_ARENA_SIZE
+    ? 1 : -1];
+
+// the infinity mask of ec_wnaf_tables has a bit per entry
+typedef char ec_wnaf_mask_fits[EC_WNAF_MAX_POINTS * EC_WNAF_ENTRIES <= 32 ? 1 : -1];
+
+// Recode a little-endian scalar of count words, digits are least
+// significant first, returns their number
+static inline int ec_wnaf_words(int8_t* digits, const uint32_t* k, int count) {
+    uint32_t w[EC_SCALAR_MAX_WORDS + 1];
+    for (int i = 0; i <= EC_SCALAR_MAX_WORDS; i++) {
+        w[i] = i < count ? k[i] : 0;
+    }
+
+    int len = 0;
+    for (;;) {
+        uint32_t any = 0;
+        for (int i = 0; i <= EC_SCALAR_MAX_WORDS; i++) {
+            any |= w[i];
+        }
+        if (!any) {
+            return len;
+        }
+
+        int32_t d = 0;
+        if (w[0] & 1) {
+            d = (int32_t)(w[0] & ((1U << EC_WNAF_WIDTH) - 1));
+            if (d >= (1 << (EC_WNAF_WIDTH - 1))) {
+                d -= 1 << EC_WNAF_WIDTH;
+            }
+            // w -= d, a negative digit may carry past the top of k
+            uint64_t acc = (uint64_t)w[0] - (uint64_t)(int64_t)d;
+            w[0] = (uint32_t)acc;
+            int64_t carry = (int64_t)acc >> 32;
+            for (int i = 1; i <= EC_SCALAR_MAX_WORDS && carry != 0; i++) {
+                int64_t sum = (int64_t)w[i] + carry;
+                w[i] = (uint32_t)sum;
+                carry = sum >> 32;
+            }
+        }
+        digits[len++] = (int8_t)d;
+
+        for (int i = 0; i < EC_SCALAR_MAX_WORDS; i++) {
+            w[i] = (w[i] >> 1) | (w[i + 1] << 31);
+        }
+        w[EC_SCALAR_MAX_WORDS] >>= 1;
+    }
+}
+
+static inline int ec_wnaf(int8_t* digits, const ff_t* k) {
+    return ec_wnaf_words(digits, k->words, FF_WORDS);
+}
+
+// Affine odd multiples P, 3P, ..., (2^(w-1) - 1)P of up to
+// EC_WNAF_MAX_POINTS points, table[j * EC_WNAF_ENTRIES + i] = (2i + 1) P_j.
+// Built in Jacobian coordinates in scratch_arena, two batch inversions in
+// total. A point of small order (3 or 5 on the toy curve, whose n isn't
+// prime) has multiples at infinity, they are zeroed and the returned mask
+// has bit j * EC_WNAF_ENTRIES + i set for them, see ec_add_wnaf_digit.
+static inline uint32_t ec_wnaf_tables(const ec_curve_t* curve, ECPoint* table, const ECPoint* points, int count) {
+    ARENA_SCOPE(&scratch_arena);
+    ECPointJ* jac = ARENA_NEW(&scratch_arena, ECPointJ, EC_WNAF_MAX_POINTS * EC_WNAF_ENTRIES);
+    ECPoint* twice = ARENA_NEW(&scratch_arena, ECPoint, EC_WNAF_MAX_POINTS);
+
+    for (int j = 0; j < count; j++) {
+        ec_to_jacobian(&jac[j], &points[j]);
+        ec_double_inplace(curve, &jac[j]);
+    }
+    uint32_t twice_infinite = ec_batch_to_affine(curve, twice, jac, count);
+
+    for (int j = 0; j < count; j++) {
+        ECPointJ* row = &jac[j * EC_WNAF_ENTRIES];
+        ec_to_jacobian(&row[0], &points[j]);
+        for (int i = 1; i < EC_WNAF_ENTRIES; i++) {
+            row[i] = row[i - 1];
+            // 2P at infinity leaves every odd multiple equal to P
+            if (!(twice_infinite & (1u << j))) {
+                ec_add_inplace(curve, &row[i], &twice[j]);
+            }
+        }
+    }
+    return ec_batch_to_affine(curve, table, jac, count * EC_WNAF_ENTRIES);
+}
+
+// R += digit * P from a table of odd multiples and the infinity mask of its
+// entries, adding an entry at infinity leaves R as it is
+static inline void ec_add_wnaf_digit(const ec_curve_t* curve, ECPointJ* R, const ECPoint* table,
+                                     uint32_t infinite, int digit) {
+    int index = (digit < 0 ? -digit : digit) / 2;
+    if (digit == 0 || (infinite & (1u << index))) {
+        return;
+    }
+    if (digit > 0) {
+        ec_add_inplace(curve, R, &table[index]);
     } else {
-        // Point addition: m = (y2 - y1)/(x2 - x1)
-        ff_t num, denom, temp;
-        
-        ff_sub(&num, &P2->y, &P1->y);      // y2 - y1
-        ff_sub(&denom, &P2->x, &P1->x);    // x2 - x1
-        
-        ff_mod_inv(&temp, &denom);         // Modular inverse of denominator
-        ff_mod_mul(&m, &num, &temp, &p);   // Multiply by numerator mod p
-    }
-    
-    // Calculate x3 = m^2 - x1 - x2
-    ff_t x3;
-    ff_mod_mul(&x3, &m, &m, &p);          // m^2
-    ff_mod_sub(&x3, &x3, &P1->x, &p);     // m^2 - x1
-    ff_mod_sub(&x3, &x3, &P2->x, &p);     // m^2 - x1 - x2
-    
-    // Calculate y3 = m(x1 - x3) - y1
-    ff_t y3, temp;
-    ff_sub(&temp, &P1->x, &x3);          // x1 - x3
-    ff_mod_mul(&y3, &m, &temp, &p);      // m(x1 - x3)
-    ff_mod_sub(&y3, &y3, &P1->y, &p);    // m(x1 - x3) - y1
-    
-    result->x = x3;
-    result->y = y3;
-    result->is_infinity = 0;
-}
-
-// Scalar multiplication using double-and-add algorithm
-static inline void ec_scalar_mul(ECPoint* result, const ECPoint* P, const ff_t* k) {
-    ECPoint R;
-    ec_set_infinity(&R);
-    ECPoint temp = *P;
-    
-    // Process from LSB to MSB
-    for (int i = 0; i < FF_SIZE; i++) {
-        int word_idx = i / 32;
-        int bit_idx = i % 32;
-        
-        ec_add(&R, &R, &R);
-        
-        if ((k->words[word_idx] >> bit_idx) & 1) {
-            ec_add(&R, &R, &temp);
-        }
-    }
-    
-    *result = R;
-}
-
-static inline void ec_init_random_k(ff_t *result) {
-    ff_t temp;
+        const ECPoint* Q = &table[index];
+        ff_t neg_y;
+        fp_sub(curve, &neg_y, &curve->p.m, &Q->y);
+        ec_add_xy_inplace(curve, R, &Q->x, &neg_y);
+    }
+}
+
+// Random non-zero field element
+static inline void ec_random_fp(const ec_curve_t* curve, ff_t* result) {
+    do {
+        for (int i = 0; i < FF_WORDS; i++) {
+            result->words[i] = nextRand();
+        }
+        ff_modulus_reduce(&curve->p, result, result);
+    } while (ff_is_zero(result));
+}
+
+// (X, Y, Z) -> (l^2 X, l^3 Y, l Z) for a random l, the same point with
+// unpredictable coordinates
+static inline void ec_randomize_j(const ec_curve_t* curve, ECPointJ* P) {
+    ff_t l, l2;
+    ec_random_fp(curve, &l);
+    fp_sqr(curve, &l2, &l);
+    fp_mul(curve, &P->x, &P->x, &l2);
+    fp_mul(curve, &l2, &l2, &l);
+    fp_mul(curve, &P->y, &P->y, &l2);
+    fp_mul(curve, &P->z, &P->z, &l);
+}
+
+// k * P for a scalar of count words with a width-4 NAF, from the most
+// significant digit down. With randomize_z the accumulator starts from
+// randomized coordinates so no intermediate value is predictable.
+static inline void ec_scalar_mul_words(const ec_curve_t* curve, ECPointJ* R, const ECPoint* P,
+                                       const uint32_t* k, int count, int randomize_z) {
+    ECPoint table[EC_WNAF_ENTRIES];
+    int8_t digits[EC_WNAF_MAX_DIGITS];
+    uint32_t infinite = ec_wnaf_tables(curve, table, P, 1);
+    int len = ec_wnaf_words(digits, k, count);
+
+    ec_set_infinity_j(R);
+    if (len == 0) {
+        return;
+    }
+
+    // the leading digit is positive, start from it instead of infinity
+    int lead = digits[len - 1] / 2;
+    if (!(infinite & (1u << lead))) {
+        ec_to_jacobian(R, &table[lead]);
+    }
+    if (randomize_z) {
+        ec_randomize_j(curve, R);
+    }
+    for (int i = len - 2; i >= 0; i--) {
+        ec_double_inplace(curve, R);
+        ec_add_wnaf_digit(curve, R, table, infinite, digits[i]);
+    }
+}
+
+// Scalar multiplication with a width-4 NAF, in Jacobian coordinates so
+// there is a single inversion at the end. Returns 0 if k * P is the point
+// at infinity.
+static inline int ec_scalar_mul(const ec_curve_t* curve, ECPoint* result, const ECPoint* P, const ff_t* k) {
+    ECPointJ R;
+    ec_scalar_mul_words(curve, &R, P, k->words, FF_WORDS, 0);
+    return ec_to_affine(curve, result, &R);
+}
+
+// Build the comb table of a fixed base point, see EC_COMB_TEETH. Entries
+// are built in layers of equal popcount, each layer only needs affine
+// entries of the layers before it and is normalized with one batch inversion.
+// table[0] would be the point at infinity, it is zeroed and never read.
+// The working copies (about 2.6 KB for 256-bit fields) live in scratch_arena.
+static inline void ec_comb_init(const ec_curve_t* curve, ECPoint* table, const ECPoint* P) {
+    ARENA_SCOPE(&scratch_arena);
+    ECPointJ* jac = ARENA_NEW(&scratch_arena, ECPointJ, EC_COMB_ENTRIES);
+    ECPoint* affine = ARENA_NEW(&scratch_arena, ECPoint, EC_COMB_ENTRIES);
+    int* index = ARENA_NEW(&scratch_arena, int, EC_COMB_ENTRIES);
+    ff_zero(&table[0].x);
+    ff_zero(&table[0].y);
+
+    // the teeth 2^(64 j) P
+    ECPointJ R;
+    ec_to_jacobian(&R, P);
+    for (int j = 0; j < EC_COMB_TEETH; j++) {
+        for (int i = 0; j > 0 && i < EC_COMB_SPACING; i++) {
+            ec_double_inplace(curve, &R);
+        }
+        jac[j] = R;
+    }
+    ec_batch_to_affine(curve, affine, jac, EC_COMB_TEETH);
+    for (int j = 0; j < EC_COMB_TEETH; j++) {
+        table[1 << j] = affine[j];
+    }
+
+    // every other entry adds its top tooth to an entry of the layer below
+    for (int bits = 2; bits <= EC_COMB_TEETH; bits++) {
+        int count = 0;
+        for (int i = 3; i < EC_COMB_ENTRIES; i++) {
+            int popcount = 0;
+            int top = 1;
+            for (int b = i; b != 0; b >>= 1) {
+                popcount += b & 1;
+            }
+            if (popcount != bits) {
+                continue;
+            }
+            while (2 * top <= i) {
+                top *= 2;
+            }
+            ec_to_jacobian(&jac[count], &table[i - top]);
+            ec_add_inplace(curve, &jac[count], &table[top]);
+            index[count++] = i;
+        }
+        ec_batch_to_affine(curve, affine, jac, count);
+        for (int i = 0; i < count; i++) {
+            table[index[i]] = affine[i];
+        }
+    }
+}
+
+// k * G with the comb, 64 doublings and at most 64 mixed additions.
+// Returns 0 if k is a multiple of n.
+static inline int ec_scalar_mul_base(const ec_curve_t* curve, ECPoint* result, const ff_t* k) {
+    ECPointJ R;
+    ec_set_infinity_j(&R);
+
+    for (int i = EC_COMB_SPACING - 1; i >= 0; i--) {
+        ec_double_inplace(curve, &R);
+
+        uint32_t idx = 0;
+        for (int j = 0; j < EC_COMB_TEETH; j++) {
+            int bit = i + j * EC_COMB_SPACING;
+            idx |= ((k->words[bit / 32] >> (bit % 32)) & 1) << j;
+        }
+        if (idx) {
+            ec_add_inplace(curve, &R, &curve->g_comb[idx]);
+        }
+    }
+
+    return ec_to_affine(curve, result, &R);
+}
+
+// u1 * P1 + u2 * P2 with interleaved width-4 NAFs, both scalars share one
+// chain of doublings and the odd multiples of both points are normalized
+// together. Returns 0 if the sum is the point at infinity.
+static inline int ec_double_scalar_mul(const ec_curve_t* curve, ECPoint* result,
+                                        const ff_t* u1, const ECPoint* P1,
+                                        const ff_t* u2, const ECPoint* P2) {
+    ECPoint points[2] = { *P1, *P2 };
+    ECPoint table[2 * EC_WNAF_ENTRIES];
+    int8_t digits1[EC_WNAF_MAX_DIGITS], digits2[EC_WNAF_MAX_DIGITS];
+    uint32_t infinite = ec_wnaf_tables(curve, table, points, 2);
+    int len1 = ec_wnaf(digits1, u1);
+    int len2 = ec_wnaf(digits2, u2);
+    int len = len1 > len2 ? len1 : len2;
+
+    ECPointJ R;
+    ec_set_infinity_j(&R);
+
+    for (int i = len - 1; i >= 0; i--) {
+        ec_double_inplace(curve, &R);
+        if (i < len1) {
+            ec_add_wnaf_digit(curve, &R, table, infinite, digits1[i]);
+        }
+        if (i < len2) {
+            ec_add_wnaf_digit(curve, &R, table + EC_WNAF_ENTRIES, infinite >> EC_WNAF_ENTRIES,
+                              digits2[i]);
+        }
+    }
+
+    return ec_to_affine(curve, result, &R);
+}
+
+// Side-channel countermeasures for ec_scalar_mul_blinded, each one can be
+// switched on separately to measure its cost
+#define EC_BLIND_SCALAR (1u << 0)   // multiply by k + r * n for a random 32-bit r
+#define EC_BLIND_Z      (1u << 1)   // randomize the Jacobian accumulator
+#define EC_BLIND_POINT  (1u << 2)   // k * (P + Q) - k * Q for a random Q = r * G
+#define EC_BLIND_ALL    (EC_BLIND_SCALAR | EC_BLIND_Z | EC_BLIND_POINT)
+
+// k * P with the selected countermeasures, k must be reduced mod n and P in
+// the group generated by G. The result equals ec_scalar_mul, only the
+// operations and intermediate values change from one call to the next.
+// Returns 0 if k * P is the point at infinity.
+static inline int ec_scalar_mul_blinded(const ec_curve_t* curve, ECPoint* result, const ECPoint* P,
+                                         const ff_t* k, uint32_t countermeasures) {
+    ECPoint base = *P;
+    ECPoint kQ;
+    int have_kQ = 0;
+
+    // kQ = (k * r) * G from the comb table, so the blinding point costs
+    // two fixed-base multiplications instead of a variable-base one. An r
+    // of 0 (Q at infinity) or a Q that cancels P is drawn again, kQ is
+    // infinity when n is not prime and k * r = 0 mod n.
+    if (countermeasures & EC_BLIND_POINT) {
+        ff_t r, kr;
+        ECPoint Q;
+        do {
+            ec_init_random_k(curve, &r);
+        } while (ff_is_zero(&r) || !ec_scalar_mul_base(curve, &Q, &r) || !ec_add(curve, &base, P, &Q));
+        fn_mul(curve, &kr, k, &r);
+        have_kQ = ec_scalar_mul_base(curve, &kQ, &kr);
+    }
+
+    // k + r * n is an equivalent scalar with a different bit pattern
+    uint32_t scalar[EC_SCALAR_MAX_WORDS];
+    int count = FF_WORDS;
     for (int i = 0; i < FF_WORDS; i++) {
-        temp.words[i] = nextRand();
+        scalar[i] = k->words[i];
+    }
+    if (countermeasures & EC_BLIND_SCALAR) {
+        uint32_t r = nextRand();
+        uint64_t carry = 0;
+        for (int i = 0; i < FF_WORDS; i++) {
+            carry += (uint64_t)r * curve->n.m.words[i] + scalar[i];
+            scalar[i] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        scalar[FF_WORDS] = (uint32_t)carry;
+        count = FF_WORDS + 1;
+    }
+
+    ECPointJ R;
+    ec_scalar_mul_words(curve, &R, &base, scalar, count, (countermeasures & EC_BLIND_Z) != 0);
+
+    if (have_kQ) {
+        ff_t neg_y;
+        fp_sub(curve, &neg_y, &curve->p.m, &kQ.y);
+        ec_add_xy_inplace(curve, &R, &kQ.x, &neg_y);
+    }
+
+    return ec_to_affine(curve, result, &R);
+}
+
+// Derive the reduction constants and tables of a curve and pick its fast
+// paths: a dedicated reduction for known primes, Barrett or Montgomery
+// otherwise, and the doubling formula matching a
+static inline void ec_curve_init(ec_curve_t* curve, const ec_params_t* params) {
+    curve->name = params->name;
+    ff_modulus_init(&curve->p, &params->p);
+    ff_modulus_init(&curve->n, &params->n);
+    if (ff_eq(&params->p, &ec_params_p256.p)) {
+        curve->p.mul = ec_p256_mul;
+    } else if (ff_eq(&params->p, &ec_params_secp256k1.p)) {
+        curve->p.mul = ec_secp256k1_mul;
+    }
+
+    curve->a = params->a;
+    curve->b = params->b;
+    ec_init_point(&curve->g, &params->gx, &params->gy);
+
+    ff_t temp;
+    ff_from_u32(&temp, 3);
+    fp_add(curve, &temp, &curve->a, &temp);
+    curve->a_is_minus_3 = ff_is_zero(&temp);
+    curve->a_is_zero = ff_is_zero(&curve->a);
+
+    // (p + 1) / 4 = (p >> 2) + 1 when p = 3 mod 4
+    curve->p_is_3_mod_4 = (params->p.words[0] & 3) == 3;
+    ff_zero(&curve->p_plus_1_div_4);
+    if (curve->p_is_3_mod_4) {
+        ff_from_u32(&temp, 1);
+        ff_shr(&curve->p_plus_1_div_4, &params->p, 2);
+        ff_add(&curve->p_plus_1_div_4, &curve->p_plus_1_div_4, &temp);
+    }
+
+    ec_comb_init(curve, curve->g_comb, &curve->g);
+}
+
+// Shared, lazily initialized P-256 descriptor
+static inline const ec_curve_t* ec_curve_p256(void) {
+    static ec_curve_t curve;
+    static int ready = 0;
+    if (!ready) {
+        ec_curve_init(&curve, &ec_params_p256);
+        ready = 1;
     }
-    ff_mod(result, &temp, &n);
+    return &curve;
 }
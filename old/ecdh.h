@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ff.h"
+#include "ec.h"
+
+// SEC1 point encodings: 0x04 || x || y, or 0x02 / 0x03 || x where the
+// prefix carries the parity of y
+#define EC_SEC1_COMPRESSED_BYTES (1 + FF_BYTES)
+#define EC_SEC1_UNCOMPRESSED_BYTES (1 + 2 * FF_BYTES)
+
+// Right hand side of the curve equation: x^3 + ax + b
+static inline void ec_curve_rhs(const ec_curve_t* curve, ff_t* result, const ff_t* x) {
+    ff_t temp;
+    fp_sqr(curve, &temp, x);                    // x^2
+    fp_add(curve, &temp, &temp, &curve->a);     // x^2 + a
+    fp_mul(curve, &temp, &temp, x);             // x^3 + ax
+    fp_add(curve, result, &temp, &curve->b);    // x^3 + ax + b
+}
+
+// Check that y^2 = x^3 + ax + b, the coordinates must be reduced
+static inline int ec_is_on_curve(const ec_curve_t* curve, const ECPoint* P) {
+    ff_t lhs, rhs;
+    fp_sqr(curve, &lhs, &P->y);
+    ec_curve_rhs(curve, &rhs, &P->x);
+    return ff_eq(&lhs, &rhs);
+}
+
+// Validate a peer public key before using it. P-256 and secp256k1 have
+// cofactor 1 so any affine point on the curve is in the prime order
+// subgroup, infinity has no ECPoint form and no SEC1 encoding is accepted
+// for it.
+static inline int ec_validate_public_key(const ec_curve_t* curve, const ECPoint* Q) {
+    if (ff_cmp(&Q->x, &curve->p.m) >= 0 || ff_cmp(&Q->y, &curve->p.m) >= 0) {
+        return 0;
+    }
+    return ec_is_on_curve(curve, Q);
+}
+
+// Encode a point in SEC1 format, returns the number of bytes written
+// (EC_SEC1_COMPRESSED_BYTES or EC_SEC1_UNCOMPRESSED_BYTES)
+static inline size_t ec_encode_point(uint8_t* buffer, const ECPoint* P, int compressed) {
+    if (compressed) {
+        buffer[0] = 0x02 | (P->y.words[0] & 1);
+        ff_to_bytes(buffer + 1, &P->x);
+        return EC_SEC1_COMPRESSED_BYTES;
+    }
+    buffer[0] = 0x04;
+    ff_to_bytes(buffer + 1, &P->x);
+    ff_to_bytes(buffer + 1 + FF_BYTES, &P->y);
+    return EC_SEC1_UNCOMPRESSED_BYTES;
+}
+
+// Recover y from x and its parity, returns 0 if x is not on the curve
+static inline int ec_decompress_point(const ec_curve_t* curve, ECPoint* result, const ff_t* x, int y_odd) {
+    if (ff_cmp(x, &curve->p.m) >= 0) {
+        return 0;
+    }
+
+    ff_t rhs, y;
+    ec_curve_rhs(curve, &rhs, x);
+    if (!fp_sqrt(curve, &y, &rhs)) {
+        return 0;
+    }
+    if ((int)(y.words[0] & 1) != (y_odd != 0)) {
+        fp_sub(curve, &y, &curve->p.m, &y);
+    }
+
+    ec_init_point(result, x, &y);
+    return 1;
+}
+
+// Decode and validate a SEC1 encoded point, returns 0 on any malformed or
+// invalid input
+static inline int ec_decode_point(const ec_curve_t* curve, ECPoint* result, const uint8_t* buffer, size_t len) {
+    ff_t x, y;
+
+    if (len == EC_SEC1_COMPRESSED_BYTES && (buffer[0] == 0x02 || buffer[0] == 0x03)) {
+        ff_from_bytes(&x, buffer + 1);
+        return ec_decompress_point(curve, result, &x, buffer[0] & 1);
+    }
+
+    if (len == EC_SEC1_UNCOMPRESSED_BYTES && buffer[0] == 0x04) {
+        ff_from_bytes(&x, buffer + 1);
+        ff_from_bytes(&y, buffer + 1 + FF_BYTES);
+        ec_init_point(result, &x, &y);
+        return ec_validate_public_key(curve, result);
+    }
+
+    return 0;
+}
+
+// Generate a key pair, priv in [1, n - 1] and pub = priv * G
+static inline void ecdh_keygen(const ec_curve_t* curve, ff_t* priv, ECPoint* pub) {
+    do {
+        ec_init_random_k(curve, priv);
+    } while (ff_is_zero(priv));
+    ec_scalar_mul_base(curve, pub, priv);
+}
+
+// Compute the shared secret, the big-endian x coordinate of priv * peer_pub.
+// The peer key is validated first, returns 0 if it or the result are invalid.
+static inline int ecdh_shared_secret(const ec_curve_t* curve, uint8_t* secret,
+                                     const ff_t* priv, const ECPoint* peer_pub) {
+    if (ff_is_zero(priv) || ff_cmp(priv, &curve->n.m) >= 0) {
+        return 0;
+    }
+    if (!ec_validate_public_key(curve, peer_pub)) {
+        return 0;
+    }
+
+    ECPoint shared;
+    if (!ec_scalar_mul(curve, &shared, peer_pub, priv)) {
+        return 0;
+    }
+
+    ff_to_bytes(secret, &shared.x);
+    return 1;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stdint.h>
+#include "ff.h"
+#include "ec.h"
+#include "sha256.h"
+
+// ECDSA with SHA-256 and deterministic nonces (RFC 6979), for curves with a
+// 256-bit prime order such as P-256 and secp256k1
+
+#define ECDSA_HASH_BYTES SHA256_DIGEST_BYTES
+
+// bits2int of a 256-bit hash reduced mod n, qlen == hlen so no shift is needed
+static inline void ecdsa_hash_to_scalar(const ec_curve_t* curve, ff_t* result, const uint8_t* hash) {
+    ff_t e;
+    ff_from_bytes(&e, hash);
+    fn_reduce(curve, result, &e);
+}
+
+// RFC 6979 HMAC_DRBG state, section 3.2
+typedef struct {
+    uint8_t k[SHA256_DIGEST_BYTES];
+    uint8_t v[SHA256_DIGEST_BYTES];
+} ecdsa_nonce_t;
+
+// K = HMAC_K(V || tag || extra), V = HMAC_K(V)
+static inline void ecdsa_nonce_update(ecdsa_nonce_t* drbg, uint8_t tag,
+                                      const uint8_t* x, const uint8_t* h) {
+    hmac_sha256_t mac;
+    hmac_sha256_init(&mac, drbg->k, sizeof(drbg->k));
+    hmac_sha256_update(&mac, drbg->v, sizeof(drbg->v));
+    hmac_sha256_update(&mac, &tag, 1);
+    if (x) {
+        hmac_sha256_update(&mac, x, FF_BYTES);
+        hmac_sha256_update(&mac, h, FF_BYTES);
+    }
+    hmac_sha256_final(&mac, drbg->k);
+
+    hmac_sha256_init(&mac, drbg->k, sizeof(drbg->k));
+    hmac_sha256_update(&mac, drbg->v, sizeof(drbg->v));
+    hmac_sha256_final(&mac, drbg->v);
+}
+
+// Steps b. to f., seeds the generator with the private key and the hash
+static inline void ecdsa_nonce_init(const ec_curve_t* curve, ecdsa_nonce_t* drbg,
+                                    const ff_t* priv, const uint8_t* hash) {
+    uint8_t x[FF_BYTES], h[FF_BYTES];
+    ff_t e;
+
+    ff_to_bytes(x, priv);
+    ecdsa_hash_to_scalar(curve, &e, hash);  // bits2octets(h1)
+    ff_to_bytes(h, &e);
+
+    for (int i = 0; i < SHA256_DIGEST_BYTES; i++) {
+        drbg->v[i] = 0x01;
+        drbg->k[i] = 0x00;
+    }
+    ecdsa_nonce_update(drbg, 0x00, x, h);
+    ecdsa_nonce_update(drbg, 0x01, x, h);
+}
+
+// Step h., produces the next candidate k in [1, n - 1]
+static inline void ecdsa_nonce_next(const ec_curve_t* curve, ecdsa_nonce_t* drbg, ff_t* k) {
+    for (;;) {
+        hmac_sha256_t mac;
+        hmac_sha256_init(&mac, drbg->k, sizeof(drbg->k));
+        hmac_sha256_update(&mac, drbg->v, sizeof(drbg->v));
+        hmac_sha256_final(&mac, drbg->v);
+
+        ff_from_bytes(k, drbg->v);
+        if (!ff_is_zero(k) && ff_cmp(k, &curve->n.m) < 0) {
+            return;
+        }
+        ecdsa_nonce_update(drbg, 0x00, 0, 0);
+    }
+}
+
+// Sign a SHA-256 hash, returns 0 if the private key is out of range
+static inline int ecdsa_sign(const ec_curve_t* curve, ff_t* r, ff_t* s,
+                             const ff_t* priv, const uint8_t* hash) {
+    if (ff_is_zero(priv) || ff_cmp(priv, &curve->n.m) >= 0) {
+        return 0;
+    }
+
+    ff_t e, k, kinv, temp;
+    ECPoint R;
+    ecdsa_hash_to_scalar(curve, &e, hash);
+
+    ecdsa_nonce_t drbg;
+    ecdsa_nonce_init(curve, &drbg, priv, hash);
+
+    for (;;) {
+        ecdsa_nonce_next(curve, &drbg, &k);
+
+        // r = (k * G).x mod n
+        ec_scalar_mul_base(curve, &R, &k);
+        fn_reduce(curve, r, &R.x);
+        if (ff_is_zero(r)) {
+            ecdsa_nonce_update(&drbg, 0x00, 0, 0);
+            continue;
+        }
+
+        // s = k^-1 * (e + r * d) mod n
+        fn_mul(curve, &temp, r, priv);
+        fn_add(curve, &temp, &temp, &e);
+        fn_inv(curve, &kinv, &k);
+        fn_mul(curve, s, &kinv, &temp);
+        if (ff_is_zero(s)) {
+            ecdsa_nonce_update(&drbg, 0x00, 0, 0);
+            continue;
+        }
+        return 1;
+    }
+}
+
+// Verify a signature on a SHA-256 hash, the public key must be validated
+static inline int ecdsa_verify(const ec_curve_t* curve, const ff_t* r, const ff_t* s,
+                               const ECPoint* pub, const uint8_t* hash) {
+    const ff_t* n = &curve->n.m;
+    if (ff_is_zero(r) || ff_cmp(r, n) >= 0 || ff_is_zero(s) || ff_cmp(s, n) >= 0) {
+        return 0;
+    }
+
+    ff_t e, w, u1, u2, v;
+    ecdsa_hash_to_scalar(curve, &e, hash);
+
+    // u1 = e / s, u2 = r / s
+    fn_inv(curve, &w, s);
+    fn_mul(curve, &u1, &e, &w);
+    fn_mul(curve, &u2, r, &w);
+
+    // R = u1 * G + u2 * Q, valid if R.x mod n == r
+    ECPoint R;
+    if (!ec_double_scalar_mul(curve, &R, &u1, &curve->g, &u2, pub)) {
+        return 0;
+    }
+    fn_reduce(curve, &v, &R.x);
+    return ff_eq(&v, r);
+}
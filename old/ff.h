@@ -13,6 +13,11 @@ typedef struct {
     uint32_t words[FF_WORDS];  // Little-endian representation
 } ff_t;
 
+// Double width (512-bit) integer, holds the full product of two ff_t
+typedef struct {
+    uint32_t words[2 * FF_WORDS];  // Little-endian representation
+} ff_wide_t;
+
 // Initialize ff_t from a 32-bit value
 static inline void ff_from_u32(ff_t* result, uint32_t value) {
     result->words[0] = value;
@@ -172,7 +177,7 @@ static inline void ff_to_hex(uint8_t* buffer, const ff_t* a) {
     }
 }
 
-static void ff_from_hex(ff_t* result, const char* hex) {
+static inline void ff_from_hex(ff_t* result, const char* hex) {
     ff_zero(result);
     int len = 0;
     while (hex[len] != '\0') len++;
@@ -201,31 +206,53 @@ static void ff_from_hex(ff_t* result, const char* hex) {
     }
 }
 
+// Big-endian byte encoding, as used by SEC1 and most test vectors
+static inline void ff_to_bytes(uint8_t* buffer, const ff_t* a) {
+    for (int i = 0; i < FF_WORDS; i++) {
+        uint32_t word = a->words[FF_LAST_WORD - i];
+        buffer[4 * i + 0] = (uint8_t)(word >> 24);
+        buffer[4 * i + 1] = (uint8_t)(word >> 16);
+        buffer[4 * i + 2] = (uint8_t)(word >> 8);
+        buffer[4 * i + 3] = (uint8_t)word;
+    }
+}
+
+static inline void ff_from_bytes(ff_t* result, const uint8_t* buffer) {
+    for (int i = 0; i < FF_WORDS; i++) {
+        result->words[FF_LAST_WORD - i] = ((uint32_t)buffer[4 * i + 0] << 24) |
+                                          ((uint32_t)buffer[4 * i + 1] << 16) |
+                                          ((uint32_t)buffer[4 * i + 2] << 8) |
+                                          (uint32_t)buffer[4 * i + 3];
+    }
+}
+
 // Helper function to compare ff_t with hex string
-static int ff_equals_hex(const ff_t* a, const char* hex) {
+static inline int ff_equals_hex(const ff_t* a, const char* hex) {
     ff_t expected;
     ff_from_hex(&expected, hex);
     return ff_eq(a, &expected);
 }
 
-// Add two ff_t values with carry propagation
-static inline void ff_add(ff_t* result, const ff_t* a, const ff_t* b) {
+// Add two ff_t values with carry propagation, returns the carry out
+static inline uint32_t ff_add(ff_t* result, const ff_t* a, const ff_t* b) {
     uint32_t carry = 0;
     for (int i = 0; i < FF_WORDS; i++) {
-        uint32_t sum = a->words[i] + b->words[i] + carry;
-        carry = (sum < a->words[i]) || ((sum == a->words[i]) && (b->words[i] > 0));
-        result->words[i] = sum;
+        uint64_t sum = (uint64_t)a->words[i] + b->words[i] + carry;
+        result->words[i] = (uint32_t)sum;
+        carry = (uint32_t)(sum >> 32);
     }
+    return carry;
 }
 
-// Subtract two ff_t values with borrow propagation
-static inline void ff_sub(ff_t* result, const ff_t* a, const ff_t* b) {
+// Subtract two ff_t values with borrow propagation, returns the borrow out
+static inline uint32_t ff_sub(ff_t* result, const ff_t* a, const ff_t* b) {
     uint32_t borrow = 0;
     for (int i = 0; i < FF_WORDS; i++) {
-        uint32_t diff = a->words[i] - b->words[i] - borrow;
-        borrow = (diff > a->words[i]) || ((diff == a->words[i]) && (b->words[i] > 0));
-        result->words[i] = diff;
+        uint64_t diff = (uint64_t)a->words[i] - b->words[i] - borrow;
+        result->words[i] = (uint32_t)diff;
+        borrow = (uint32_t)(diff >> 32) & 1;
     }
+    return borrow;
 }
 
 // Optimized multiplication using the Cortex-M4's DSP instructions
@@ -249,6 +276,44 @@ static inline void ff_mul(ff_t* result, const ff_t* a, const ff_t* b) {
     }
 }
 
+// Full 256x256 -> 512 bit product, the UMAAL-friendly inner loop maps to a
+// single 32x32+32+32 -> 64 multiply-accumulate on the Cortex-M4
+static inline void ff_mul_wide(ff_wide_t* result, const ff_t* a, const ff_t* b) {
+    for (int i = 0; i < 2 * FF_WORDS; i++) {
+        result->words[i] = 0;
+    }
+
+    for (int i = 0; i < FF_WORDS; i++) {
+        uint32_t carry = 0;
+        for (int j = 0; j < FF_WORDS; j++) {
+            uint64_t product = (uint64_t)a->words[i] * b->words[j] +
+                             result->words[i + j] + carry;
+            result->words[i + j] = (uint32_t)product;
+            carry = (uint32_t)(product >> 32);
+        }
+        result->words[i + FF_WORDS] = carry;
+    }
+}
+
+// Reduce a 512-bit value modulo an arbitrary modulus, one bit at a time.
+// Slow, but correct for any modulus, curve specific code should use a
+// dedicated reduction instead.
+static inline void ff_mod_wide(ff_t* result, const ff_wide_t* a, const ff_t* modulus) {
+    ff_t temp;
+    ff_zero(&temp);
+
+    for (int i = 2 * FF_SIZE - 1; i >= 0; i--) {
+        uint32_t top = temp.words[FF_LAST_WORD] >> 31;
+        ff_shl(&temp, &temp, 1);
+        temp.words[0] |= (a->words[i / 32] >> (i % 32)) & 1;
+        if (top || ff_cmp(&temp, modulus) >= 0) {
+            ff_sub(&temp, &temp, modulus);
+        }
+    }
+
+    *result = temp;
+}
+
 static inline void ff_mod(ff_t* result, const ff_t* a, const ff_t* modulus) {
     // If a < modulus, we're done
     if (ff_cmp(a, modulus) < 0) {
@@ -281,10 +346,70 @@ static inline void ff_mod(ff_t* result, const ff_t* a, const ff_t* modulus) {
     *result = temp;
 }
 
+// Barrett constant mu = floor(2^512 / m) of a 256-bit modulus, one word
+// longer than an ff_t
+typedef struct {
+    uint32_t words[FF_WORDS + 1];
+} ff_barrett_t;
+
+// Barrett reduction (HAC 14.42) of a 512-bit value, only needs multiplications
+// so it is much faster than ff_mod_wide. The modulus must use all 256 bits.
+static inline void ff_barrett_reduce(ff_t* result, const ff_wide_t* x,
+                                     const ff_t* modulus, const ff_barrett_t* mu) {
+    // q = floor(floor(x / 2^224) * mu / 2^288)
+    const uint32_t* q1 = &x->words[FF_LAST_WORD];
+    uint32_t q2[2 * (FF_WORDS + 1)] = {0};
+    for (int i = 0; i <= FF_WORDS; i++) {
+        uint32_t carry = 0;
+        for (int j = 0; j <= FF_WORDS; j++) {
+            uint64_t product = (uint64_t)q1[i] * mu->words[j] + q2[i + j] + carry;
+            q2[i + j] = (uint32_t)product;
+            carry = (uint32_t)(product >> 32);
+        }
+        q2[i + FF_WORDS + 1] = carry;
+    }
+    const uint32_t* q3 = &q2[FF_WORDS + 1];
+
+    // r = (x - q * m) mod 2^288, the true remainder is at most 2m away
+    uint32_t qm[FF_WORDS + 1] = {0};
+    for (int i = 0; i <= FF_WORDS; i++) {
+        uint32_t carry = 0;
+        for (int j = 0; j < FF_WORDS && i + j <= FF_WORDS; j++) {
+            uint64_t product = (uint64_t)q3[i] * modulus->words[j] + qm[i + j] + carry;
+            qm[i + j] = (uint32_t)product;
+            carry = (uint32_t)(product >> 32);
+        }
+        if (i == 0) {
+            qm[FF_WORDS] = carry;
+        }
+    }
+
+    uint32_t r[FF_WORDS + 1];
+    uint32_t borrow = 0;
+    for (int i = 0; i <= FF_WORDS; i++) {
+        uint64_t diff = (uint64_t)x->words[i] - qm[i] - borrow;
+        r[i] = (uint32_t)diff;
+        borrow = (uint32_t)(diff >> 32) & 1;
+    }
+
+    ff_t low;
+    for (int i = 0; i < FF_WORDS; i++) {
+        low.words[i] = r[i];
+    }
+    while (r[FF_WORDS] != 0 || ff_cmp(&low, modulus) >= 0) {
+        r[FF_WORDS] -= ff_sub(&low, &low, modulus);
+    }
+
+    *result = low;
+}
+
 // Modular addition with optimized reduction
 static inline void ff_mod_add(ff_t* result, const ff_t* a, const ff_t* b, 
                                const ff_t* modulus) {
-    ff_add(result, a, b);
+    // Fold the carry out of the top word back in before reducing
+    if (ff_add(result, a, b)) {
+        ff_sub(result, result, modulus);
+    }
     // Always perform the modular reduction
     ff_mod(result, result, modulus);
 }
@@ -292,7 +417,10 @@ static inline void ff_mod_add(ff_t* result, const ff_t* a, const ff_t* b,
 // Optimized modular subtraction
 static inline void ff_mod_sub(ff_t* result, const ff_t* a, const ff_t* b,
                                const ff_t* modulus) {
-    ff_sub(result, a, b);
+    // A borrow means the result wrapped around 2^256, bring it back
+    if (ff_sub(result, a, b)) {
+        ff_add(result, result, modulus);
+    }
     
     // Always perform the modular reduction
     ff_mod(result, result, modulus);
@@ -301,8 +429,9 @@ static inline void ff_mod_sub(ff_t* result, const ff_t* a, const ff_t* b,
 // Modular multiplication with optimized reduction
 static inline void ff_mod_mul(ff_t* result, const ff_t* a, const ff_t* b,
                                const ff_t* modulus) {
-    ff_mul(result, a, b);
-    ff_mod(result, result, modulus);
+    ff_wide_t product;
+    ff_mul_wide(&product, a, b);
+    ff_mod_wide(result, &product, modulus);
 }
 
 // Optimized modular exponentiation using window method
@@ -310,7 +439,13 @@ static inline void ff_mod_pow(ff_t* result, const ff_t* base, const ff_t* exp,
                                const ff_t* modulus) {
     ff_t temp;
     ff_from_u32(&temp, 1);
-    ff_t base_copy = *base;
+
+    // Pre-compute base^0 .. base^15
+    ff_t table[16];
+    ff_from_u32(&table[0], 1);
+    for (int i = 1; i < 16; i++) {
+        ff_mod_mul(&table[i], &table[i - 1], base, modulus);
+    }
     
     // Process 4 bits at a time (window size = 4)
     for (int i = FF_LAST_WORD; i >= 0; i--) {
@@ -324,7 +459,7 @@ static inline void ff_mod_pow(ff_t* result, const ff_t* base, const ff_t* exp,
             uint32_t window = (word >> j) & 0xF;
             if (window != 0) {
                 // Multiply by pre-computed value
-                ff_mod_mul(&temp, &temp, &base_copy, modulus);
+                ff_mod_mul(&temp, &temp, &table[window], modulus);
             }
         }
     }
@@ -376,4 +511,171 @@ static inline void ff_div(ff_t* quotient, ff_t* remainder,
         ff_shr(&shifted_divisor, &shifted_divisor, 1);
         shift--;
     }
-}
\ No newline at end of file
+}
+// Barrett constant for a modulus whose top word is non-zero, computed by
+// long division of 2^512 one bit at a time
+static inline void ff_barrett_init(ff_barrett_t* mu, const ff_t* modulus) {
+    ff_t rem;
+    ff_zero(&rem);
+    for (int i = 0; i <= FF_WORDS; i++) {
+        mu->words[i] = 0;
+    }
+
+    for (int i = 2 * FF_SIZE; i >= 0; i--) {
+        uint32_t top = rem.words[FF_LAST_WORD] >> 31;
+        ff_shl(&rem, &rem, 1);
+        rem.words[0] |= (i == 2 * FF_SIZE);
+        if (top || ff_cmp(&rem, modulus) >= 0) {
+            ff_sub(&rem, &rem, modulus);
+            mu->words[i / 32] |= 1U << (i % 32);
+        }
+    }
+}
+
+// -m^-1 mod 2^32 for Montgomery reduction, Newton iteration doubles the
+// number of correct bits each step (m must be odd)
+static inline uint32_t ff_mont_m0inv(uint32_t m0) {
+    uint32_t x = 1;
+    for (int i = 0; i < 5; i++) {
+        x *= 2 - m0 * x;
+    }
+    return 0 - x;
+}
+
+// Montgomery reduction (HAC 14.32), t * 2^-256 mod m for t < m * 2^256
+static inline void ff_mont_reduce(ff_t* result, const ff_wide_t* t,
+                                  const ff_t* modulus, uint32_t m0inv) {
+    uint32_t acc[2 * FF_WORDS + 1];
+    for (int i = 0; i < 2 * FF_WORDS; i++) {
+        acc[i] = t->words[i];
+    }
+    acc[2 * FF_WORDS] = 0;
+
+    for (int i = 0; i < FF_WORDS; i++) {
+        uint32_t u = acc[i] * m0inv;
+        uint32_t carry = 0;
+        for (int j = 0; j < FF_WORDS; j++) {
+            uint64_t product = (uint64_t)u * modulus->words[j] + acc[i + j] + carry;
+            acc[i + j] = (uint32_t)product;
+            carry = (uint32_t)(product >> 32);
+        }
+        for (int j = i + FF_WORDS; carry != 0 && j <= 2 * FF_WORDS; j++) {
+            uint64_t sum = (uint64_t)acc[j] + carry;
+            acc[j] = (uint32_t)sum;
+            carry = (uint32_t)(sum >> 32);
+        }
+    }
+
+    for (int i = 0; i < FF_WORDS; i++) {
+        result->words[i] = acc[i + FF_WORDS];
+    }
+    if (acc[2 * FF_WORDS] || ff_cmp(result, modulus) >= 0) {
+        ff_sub(result, result, modulus);
+    }
+}
+
+// A fixed odd modulus together with its precomputed reduction constants.
+// mul is picked by ff_modulus_init: Barrett when the modulus fills the top
+// word, Montgomery otherwise. Callers may replace it with a dedicated
+// reduction, for example a NIST prime.
+typedef struct ff_modulus {
+    ff_t m;
+    ff_t m_minus_2;             // Fermat inversion exponent
+    ff_barrett_t mu;            // floor(2^512 / m)
+    uint32_t m0inv;             // -m^-1 mod 2^32
+    ff_t r2;                    // 2^512 mod m, converts into Montgomery form
+    void (*mul)(const struct ff_modulus* mod, ff_t* result, const ff_t* a, const ff_t* b);
+} ff_modulus_t;
+
+static inline void ff_modulus_mul_barrett(const ff_modulus_t* mod, ff_t* result,
+                                          const ff_t* a, const ff_t* b) {
+    ff_wide_t product;
+    ff_mul_wide(&product, a, b);
+    ff_barrett_reduce(result, &product, &mod->m, &mod->mu);
+}
+
+// REDC(REDC(a * b) * R^2) = a * b, operands stay in the normal representation
+static inline void ff_modulus_mul_montgomery(const ff_modulus_t* mod, ff_t* result,
+                                             const ff_t* a, const ff_t* b) {
+    ff_wide_t product;
+    ff_t temp;
+    ff_mul_wide(&product, a, b);
+    ff_mont_reduce(&temp, &product, &mod->m, mod->m0inv);
+    ff_mul_wide(&product, &temp, &mod->r2);
+    ff_mont_reduce(result, &product, &mod->m, mod->m0inv);
+}
+
+static inline void ff_modulus_init(ff_modulus_t* mod, const ff_t* m) {
+    ff_t two;
+    ff_from_u32(&two, 2);
+    mod->m = *m;
+    ff_sub(&mod->m_minus_2, m, &two);
+    mod->m0inv = ff_mont_m0inv(m->words[0]);
+
+    // 2^512 mod m by doubling 1 512 times
+    ff_from_u32(&mod->r2, 1);
+    for (int i = 0; i < 2 * FF_SIZE; i++) {
+        ff_mod_add(&mod->r2, &mod->r2, &mod->r2, m);
+    }
+
+    if (m->words[FF_LAST_WORD] != 0) {
+        ff_barrett_init(&mod->mu, m);
+        mod->mul = ff_modulus_mul_barrett;
+    } else {
+        for (int i = 0; i <= FF_WORDS; i++) {
+            mod->mu.words[i] = 0;
+        }
+        mod->mul = ff_modulus_mul_montgomery;
+    }
+}
+
+// a + b mod m, inputs must be reduced
+static inline void ff_modulus_add(const ff_modulus_t* mod, ff_t* result, const ff_t* a, const ff_t* b) {
+    if (ff_add(result, a, b) || ff_cmp(result, &mod->m) >= 0) {
+        ff_sub(result, result, &mod->m);
+    }
+}
+
+// a - b mod m, inputs must be reduced
+static inline void ff_modulus_sub(const ff_modulus_t* mod, ff_t* result, const ff_t* a, const ff_t* b) {
+    if (ff_sub(result, a, b)) {
+        ff_add(result, result, &mod->m);
+    }
+}
+
+// Reduce any 256-bit value, every mul accepts a full width operand
+static inline void ff_modulus_reduce(const ff_modulus_t* mod, ff_t* result, const ff_t* a) {
+    ff_t one;
+    ff_from_u32(&one, 1);
+    mod->mul(mod, result, a, &one);
+}
+
+// base^exp mod m with a 4-bit fixed window
+static inline void ff_modulus_pow(const ff_modulus_t* mod, ff_t* result,
+                                  const ff_t* base, const ff_t* exp) {
+    ff_t table[16];
+    ff_from_u32(&table[0], 1);
+    for (int i = 1; i < 16; i++) {
+        mod->mul(mod, &table[i], &table[i - 1], base);
+    }
+
+    ff_t temp;
+    ff_from_u32(&temp, 1);
+    for (int i = FF_SIZE - 4; i >= 0; i -= 4) {
+        for (int k = 0; k < 4; k++) {
+            mod->mul(mod, &temp, &temp, &temp);
+        }
+        uint32_t window = (exp->words[i / 32] >> (i % 32)) & 0xF;
+        if (window != 0) {
+            mod->mul(mod, &temp, &temp, &table[window]);
+        }
+    }
+
+    *result = temp;
+}
+
+// Modular inverse of a prime modulus through Fermat's little theorem,
+// a^(m - 2). Returns zero for a zero input.
+static inline void ff_modulus_inv(const ff_modulus_t* mod, ff_t* result, const ff_t* a) {
+    ff_modulus_pow(mod, result, a, &mod->m_minus_2);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ff.h"
+#include "ec.h"
+#include "ecdh.h"
+#include "x25519.h"
+
+// Byte oriented key exchange interface so benchmarks and trace captures can
+// drive P-256 and X25519 through the same code path
+
+#define KEX_MAX_PRIV_BYTES 32
+#define KEX_MAX_PUB_BYTES EC_SEC1_UNCOMPRESSED_BYTES
+#define KEX_MAX_SECRET_BYTES 32
+
+typedef struct {
+    const char* name;
+    size_t priv_bytes;
+    size_t pub_bytes;
+    size_t secret_bytes;
+    void (*keygen)(uint8_t* priv, uint8_t* pub);
+    // returns 0 if the peer key is invalid
+    int (*shared_secret)(uint8_t* secret, const uint8_t* priv, const uint8_t* peer_pub);
+} kex_t;
+
+// P-256: big-endian private scalar, SEC1 uncompressed public key
+static inline void kex_p256_keygen(uint8_t* priv, uint8_t* pub) {
+    ff_t d;
+    ECPoint Q;
+    ecdh_keygen(ec_curve_p256(), &d, &Q);
+    ff_to_bytes(priv, &d);
+    ec_encode_point(pub, &Q, 0);
+}
+
+static inline int kex_p256_shared_secret(uint8_t* secret, const uint8_t* priv, const uint8_t* peer_pub) {
+    ff_t d;
+    ECPoint Q;
+    const ec_curve_t* curve = ec_curve_p256();
+    if (!ec_decode_point(curve, &Q, peer_pub, EC_SEC1_UNCOMPRESSED_BYTES)) {
+        return 0;
+    }
+    ff_from_bytes(&d, priv);
+    return ecdh_shared_secret(curve, secret, &d, &Q);
+}
+
+static const kex_t kex_p256 = {
+    .name = "p256",
+    .priv_bytes = FF_BYTES,
+    .pub_bytes = EC_SEC1_UNCOMPRESSED_BYTES,
+    .secret_bytes = FF_BYTES,
+    .keygen = kex_p256_keygen,
+    .shared_secret = kex_p256_shared_secret,
+};
+
+static const kex_t kex_x25519 = {
+    .name = "x25519",
+    .priv_bytes = X25519_BYTES,
+    .pub_bytes = X25519_BYTES,
+    .secret_bytes = X25519_BYTES,
+    .keygen = x25519_keygen,
+    .shared_secret = x25519_shared_secret,
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SHA-256 (FIPS 180-4) and HMAC-SHA256 (RFC 2104), used for the ECDSA
+// message digest and the RFC 6979 deterministic nonces
+
+#define SHA256_BLOCK_BYTES 64
+#define SHA256_DIGEST_BYTES 32
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;                       // total bytes hashed
+    uint8_t buffer[SHA256_BLOCK_BYTES];
+    uint32_t buffered;                     // bytes waiting in buffer
+} sha256_t;
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t sha256_rotr(uint32_t x, int k) {
+    return (x >> k) | (x << (32 - k));
+}
+
+static inline void sha256_compress(uint32_t* state, const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) |
+               ((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = sha256_rotr(w[i - 15], 7) ^ sha256_rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = sha256_rotr(w[i - 2], 17) ^ sha256_rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = sha256_rotr(e, 6) ^ sha256_rotr(e, 11) ^ sha256_rotr(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+        uint32_t s0 = sha256_rotr(a, 2) ^ sha256_rotr(a, 13) ^ sha256_rotr(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+static inline void sha256_init(sha256_t* ctx) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    for (int i = 0; i < 8; i++) {
+        ctx->state[i] = iv[i];
+    }
+    ctx->length = 0;
+    ctx->buffered = 0;
+}
+
+static inline void sha256_update(sha256_t* ctx, const uint8_t* data, size_t len) {
+    ctx->length += len;
+    while (len > 0) {
+        uint32_t take = SHA256_BLOCK_BYTES - ctx->buffered;
+        if (take > len) {
+            take = (uint32_t)len;
+        }
+        for (uint32_t i = 0; i < take; i++) {
+            ctx->buffer[ctx->buffered + i] = data[i];
+        }
+        ctx->buffered += take;
+        data += take;
+        len -= take;
+
+        if (ctx->buffered == SHA256_BLOCK_BYTES) {
+            sha256_compress(ctx->state, ctx->buffer);
+            ctx->buffered = 0;
+        }
+    }
+}
+
+static inline void sha256_final(sha256_t* ctx, uint8_t* digest) {
+    uint64_t bits = ctx->length * 8;
+
+    // Pad with 0x80, zeros up to 56 mod 64 and the big-endian bit length
+    uint8_t pad = 0x80;
+    sha256_update(ctx, &pad, 1);
+    pad = 0;
+    while (ctx->buffered != SHA256_BLOCK_BYTES - 8) {
+        sha256_update(ctx, &pad, 1);
+    }
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++) {
+        length[i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    sha256_update(ctx, length, sizeof(length));
+
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i + 0] = (uint8_t)(ctx->state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)ctx->state[i];
+    }
+}
+
+static inline void sha256(uint8_t* digest, const uint8_t* data, size_t len) {
+    sha256_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, digest);
+}
+
+typedef struct {
+    sha256_t inner;
+    sha256_t outer;
+} hmac_sha256_t;
+
+// Keys longer than a block are not needed by RFC 6979 and are not supported
+static inline void hmac_sha256_init(hmac_sha256_t* ctx, const uint8_t* key, size_t key_len) {
+    uint8_t pad[SHA256_BLOCK_BYTES];
+
+    for (size_t i = 0; i < SHA256_BLOCK_BYTES; i++) {
+        pad[i] = (i < key_len ? key[i] : 0) ^ 0x36;
+    }
+    sha256_init(&ctx->inner);
+    sha256_update(&ctx->inner, pad, sizeof(pad));
+
+    for (size_t i = 0; i < SHA256_BLOCK_BYTES; i++) {
+        pad[i] ^= 0x36 ^ 0x5c;
+    }
+    sha256_init(&ctx->outer);
+    sha256_update(&ctx->outer, pad, sizeof(pad));
+}
+
+static inline void hmac_sha256_update(hmac_sha256_t* ctx, const uint8_t* data, size_t len) {
+    sha256_update(&ctx->inner, data, len);
+}
+
+static inline void hmac_sha256_final(hmac_sha256_t* ctx, uint8_t* mac) {
+    uint8_t inner[SHA256_DIGEST_BYTES];
+    sha256_final(&ctx->inner, inner);
+    sha256_update(&ctx->outer, inner, sizeof(inner));
+    sha256_final(&ctx->outer, mac);
+}
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <time.h>
+#include "ff.h"
+#include "ec.h"
+#include "ecdh.h"
+#include "ecdsa.h"
+#include "kex.h"
+
+// Host throughput benchmarks, build in Release for meaningful numbers
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench_kex(const kex_t* kex, int iterations) {
+    uint8_t priv1[KEX_MAX_PRIV_BYTES], pub1[KEX_MAX_PUB_BYTES];
+    uint8_t priv2[KEX_MAX_PRIV_BYTES], pub2[KEX_MAX_PUB_BYTES];
+    uint8_t secret[KEX_MAX_SECRET_BYTES];
+
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        kex->keygen(priv1, pub1);
+    }
+    double elapsed = now_seconds() - start;
+    printf("%-7s keygen:   %8.1f keys/s (%d in %.3fs)\n", kex->name, iterations / elapsed, iterations, elapsed);
+
+    kex->keygen(priv2, pub2);
+    int ok = 1;
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        ok &= kex->shared_secret(secret, priv1, pub2);
+    }
+    elapsed = now_seconds() - start;
+    printf("%-7s exchange: %8.1f exchanges/s (%d in %.3fs)%s\n", kex->name, iterations / elapsed, iterations,
+           elapsed, ok ? "" : " FAILED");
+}
+
+// Fixed-base (comb) and variable-base scalar multiplication of each curve
+static void bench_curve(const ec_params_t* params, int iterations) {
+    static ec_curve_t curve;
+    double start = now_seconds();
+    for (int i = 0; i < iterations / 10; i++) {
+        ec_curve_init(&curve, params);
+    }
+    double elapsed = now_seconds() - start;
+    printf("%-9s init: %8.1f/s", curve.name, (iterations / 10) / elapsed);
+
+    ff_t k;
+    ECPoint P;
+    ec_init_random_k(&curve, &k);
+
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        ec_scalar_mul_base(&curve, &P, &k);
+    }
+    elapsed = now_seconds() - start;
+    printf("   k*G: %8.1f mul/s", iterations / elapsed);
+
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        ec_scalar_mul(&curve, &P, &curve.g, &k);
+    }
+    elapsed = now_seconds() - start;
+    printf("   k*P: %8.1f mul/s\n", iterations / elapsed);
+}
+
+// Cost of each countermeasure of ec_scalar_mul_blinded relative to none
+static void bench_blinding(const ec_params_t* params, int iterations) {
+    static ec_curve_t curve;
+    ec_curve_init(&curve, params);
+
+    static const struct {
+        const char* name;
+        uint32_t mask;
+    } sets[] = {
+        { "none", 0 },
+        { "scalar", EC_BLIND_SCALAR },
+        { "z", EC_BLIND_Z },
+        { "point", EC_BLIND_POINT },
+        { "all", EC_BLIND_ALL },
+    };
+
+    ff_t k;
+    ECPoint P;
+    ec_init_random_k(&curve, &k);
+    double baseline = 0;
+    for (size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); s++) {
+        double start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            ec_scalar_mul_blinded(&curve, &P, &curve.g, &k, sets[s].mask);
+        }
+        double elapsed = (now_seconds() - start) / iterations;
+        if (s == 0) {
+            baseline = elapsed;
+        }
+        printf("%-9s blind %-6s: %8.1f us (%+5.1f%%)\n", curve.name, sets[s].name, elapsed * 1e6,
+               100 * (elapsed / baseline - 1));
+    }
+}
+
+static void bench_decompress(int iterations) {
+    const ec_curve_t* curve = ec_curve_p256();
+    uint8_t buffer[EC_SEC1_COMPRESSED_BYTES];
+    ECPoint P;
+    ec_encode_point(buffer, &curve->g, 1);
+
+    int ok = 1;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        ok &= ec_decode_point(curve, &P, buffer, sizeof(buffer));
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("decode:   %8.1f points/s (%d in %.3fs)%s\n", iterations / elapsed, iterations, elapsed,
+           ok ? "" : " FAILED");
+}
+
+static void bench_ecdsa(int iterations) {
+    const ec_curve_t* curve = ec_curve_p256();
+    ff_t priv, r, s;
+    ECPoint pub;
+    uint8_t hash[ECDSA_HASH_BYTES];
+    ecdh_keygen(curve, &priv, &pub);
+    sha256(hash, (const uint8_t*)"bench", 5);
+
+    int ok = 1;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        ok &= ecdsa_sign(curve, &r, &s, &priv, hash);
+    }
+    double elapsed = now_seconds() - start;
+    printf("sign:     %8.1f signatures/s (%d in %.3fs)%s\n", iterations / elapsed, iterations, elapsed,
+           ok ? "" : " FAILED");
+
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        ok &= ecdsa_verify(curve, &r, &s, &pub, hash);
+    }
+    elapsed = now_seconds() - start;
+    printf("verify:   %8.1f verifications/s (%d in %.3fs)%s\n", iterations / elapsed, iterations, elapsed,
+           ok ? "" : " FAILED");
+}
+
+int main(void) {
+    initRand();
+    bench_kex(&kex_p256, 200);
+    bench_kex(&kex_x25519, 200);
+    bench_curve(&ec_params_p256, 200);
+    bench_curve(&ec_params_secp256k1, 200);
+    bench_curve(&ec_params_toy, 200);
+    bench_blinding(&ec_params_p256, 200);
+    bench_blinding(&ec_params_toy, 200);
+    bench_decompress(2000);
+    bench_ecdsa(200);
+    return 0;
+}
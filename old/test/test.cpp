@@ -3,6 +3,14 @@
 #include <assert.h>
 #include "ff.h"
 #include "ec.h"
+#include "ecdh.h"
+#include "ecdsa.h"
+#include "x25519.h"
+#include "kex.h"
+#include "frame.h"
+#include "ring.h"
+#include "arena.h"
+#include "sched.h"
 
 // Helper function to initialize ff_t from hex string
 // Test basic initialization and comparison
@@ -197,10 +205,6 @@ static void test_hex_conversion(void) {
 static void print_point(const char* prefix, const ECPoint* P) {
     uint8_t buffer[65] = {0};
     printf("%s: ", prefix);
-    if (P->is_infinity) {
-        printf("Point at infinity\n");
-        return;
-    }
     ff_to_hex(buffer, &P->x);
     printf("x = %s, ", buffer);
     ff_to_hex(buffer, &P->y);
@@ -210,26 +214,27 @@ static void print_point(const char* prefix, const ECPoint* P) {
 // Test point initialization and comparison
 static void test_point_init(void) {
     printf("Testing point initialization...\n");
+    const ec_curve_t* curve = ec_curve_p256();
     
     ECPoint P;
     
     // Test generator point initialization
-    assert(!g.is_infinity);
-    assert(ff_eq(&g.x, &gx));
-    assert(ff_eq(&g.y, &gy));
+    assert(ff_eq(&curve->g.x, &ec_params_p256.gx));
+    assert(ff_eq(&curve->g.y, &ec_params_p256.gy));
     
-    // Test point at infinity
-    ec_set_infinity(&P);
-    assert(P.is_infinity);
-    assert(ff_is_zero(&P.x));
-    assert(ff_is_zero(&P.y));
+    // Test point at infinity, only Jacobian points can hold it
+    ECPointJ J;
+    ec_set_infinity_j(&J);
+    assert(ec_is_infinity_j(&J));
+    assert(!ec_to_affine(curve, &P, &J));
+    ec_to_jacobian(&J, &curve->g);
+    assert(!ec_is_infinity_j(&J));
     
     // Test regular point initialization
     ff_t x, y;
     ff_from_hex(&x, "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296");
     ff_from_hex(&y, "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5");
     ec_init_point(&P, &x, &y);
-    assert(!P.is_infinity);
     assert(ff_eq(&P.x, &x));
     assert(ff_eq(&P.y, &y));
     
@@ -239,35 +244,34 @@ static void test_point_init(void) {
 // Test point addition
 static void test_point_addition(void) {
     printf("Testing point addition...\n");
+    const ec_curve_t* curve = ec_curve_p256();
     
     ECPoint P1, P2, result;
-    
-    // Test P + O = P
-    ec_init_point(&P1, &gx, &gy);
-    ec_set_infinity(&P2);
-    ec_add(&result, &P1, &P2);
-    assert(!result.is_infinity);
-    assert(ff_eq(&result.x, &P1.x));
-    assert(ff_eq(&result.y, &P1.y));
+    ECPointJ R;
     
     // Test O + P = P
-    ec_set_infinity(&P1);
-    ec_init_point(&P2, &gx, &gy);
-    ec_add(&result, &P1, &P2);
-    assert(!result.is_infinity);
-    assert(ff_eq(&result.x, &P2.x));
-    assert(ff_eq(&result.y, &P2.y));
+    ec_set_infinity_j(&R);
+    ec_add_inplace(curve, &R, &curve->g);
+    assert(ec_to_affine(curve, &result, &R));
+    assert(ff_eq(&result.x, &curve->g.x));
+    assert(ff_eq(&result.y, &curve->g.y));
+    
+    // Test 2O = O
+    ec_set_infinity_j(&R);
+    ec_double_inplace(curve, &R);
+    assert(ec_is_infinity_j(&R));
     
     // Test P + (-P) = O
-    ec_init_point(&P1, &gx, &gy);
-    ec_init_point(&P2, &gx, &gy);
-    ff_sub(&P2.y, &p, &P2.y);  // Negate y-coordinate
-    ec_add(&result, &P1, &P2);
-    assert(result.is_infinity);
+    ec_init_point(&P1, &curve->g.x, &curve->g.y);
+    ec_negate(curve, &P2, &P1);
+    assert(!ec_add(curve, &result, &P1, &P2));
+    ec_to_jacobian(&R, &P1);
+    ec_add_inplace(curve, &R, &P2);
+    assert(ec_is_infinity_j(&R));
     
     // Test point doubling (P + P)
-    ec_init_point(&P1, &gx, &gy);
-    ec_add(&result, &P1, &P1);
+    ec_init_point(&P1, &curve->g.x, &curve->g.y);
+    assert(ec_add(curve, &result, &P1, &P1));
     
     // Known values for 2G (can be computed with external tools)
     ff_t expected_x, expected_y;
@@ -276,30 +280,38 @@ static void test_point_addition(void) {
     assert(ff_eq(&result.x, &expected_x));
     assert(ff_eq(&result.y, &expected_y));
     
+    // In place doubling agrees, including on an aliased sum
+    ec_to_jacobian(&R, &P1);
+    ec_double_inplace(curve, &R);
+    assert(ec_to_affine(curve, &P2, &R));
+    assert(ff_eq(&P2.x, &expected_x) && ff_eq(&P2.y, &expected_y));
+    assert(ec_add(curve, &P1, &P1, &P1));
+    assert(ff_eq(&P1.x, &expected_x) && ff_eq(&P1.y, &expected_y));
+    
     printf("Point addition tests passed!\n");
 }
 
 // Test scalar multiplication
 static void test_scalar_multiplication(void) {
     printf("Testing scalar multiplication...\n");
+    const ec_curve_t* curve = ec_curve_p256();
     
     ECPoint result;
     ff_t k;
     
     // Test 0 * P = O
     ff_zero(&k);
-    ec_scalar_mul(&result, &g, &k);
-    assert(result.is_infinity);
+    assert(!ec_scalar_mul(curve, &result, &curve->g, &k));
     
     // Test 1 * P = P
     ff_from_u32(&k, 1);
-    ec_scalar_mul(&result, &g, &k);
-    assert(ff_eq(&result.x, &gx));
-    assert(ff_eq(&result.y, &gy));
+    assert(ec_scalar_mul(curve, &result, &curve->g, &k));
+    assert(ff_eq(&result.x, &curve->g.x));
+    assert(ff_eq(&result.y, &curve->g.y));
     
     // Test 2 * P
     ff_from_u32(&k, 2);
-    ec_scalar_mul(&result, &g, &k);
+    ec_scalar_mul(curve, &result, &curve->g, &k);
     
     // Known values for 2G
     ff_t expected_x, expected_y;
@@ -309,8 +321,7 @@ static void test_scalar_multiplication(void) {
     assert(ff_eq(&result.y, &expected_y));
     
     // Test that n * G = O (where n is the group order)
-    ec_scalar_mul(&result, &g, &n);
-    assert(result.is_infinity);
+    assert(!ec_scalar_mul(curve, &result, &curve->g, &curve->n.m));
     
     printf("Scalar multiplication tests passed!\n");
 }
@@ -318,16 +329,17 @@ static void test_scalar_multiplication(void) {
 // Test random k generation
 static void test_random_k(void) {
     printf("Testing random k generation...\n");
+    const ec_curve_t* curve = ec_curve_p256();
     
     ff_t k;
     
     // Test multiple random values
     for (int i = 0; i < 10; i++) {
-        ec_init_random_k(&k);
+        ec_init_random_k(curve, &k);
         
         // Verify k is in range [1, n-1]
         assert(!ff_is_zero(&k));
-        assert(ff_cmp(&k, &n) < 0);
+        assert(ff_cmp(&k, &curve->n.m) < 0);
     }
     
     printf("Random k generation tests passed!\n");
@@ -336,6 +348,7 @@ static void test_random_k(void) {
 // Test point validation
 static void test_point_validation(void) {
     printf("Testing point validation...\n");
+    const ec_curve_t* curve = ec_curve_p256();
     
     ECPoint P;
     ff_t temp1, temp2, temp3;
@@ -343,15 +356,14 @@ static void test_point_validation(void) {
     // Test generator point satisfies curve equation y^2 = x^3 + ax + b
     
     // Calculate right side: x^3 + ax + b
-    ff_mul(&temp1, &gx, &gx);       // x^2
-    ff_mod_mul(&temp1, &temp1, &gx, &p);  // x^3
-    ff_mod_mul(&temp2, &a, &gx, &p);      // ax
-    ff_mod_add(&temp1, &temp1, &temp2, &p); // x^3 + ax
-    ff_mod_add(&temp1, &temp1, &b, &p);     // x^3 + ax + b
+    ff_mod_mul(&temp1, &curve->g.x, &curve->g.x, &curve->p.m);     // x^2
+    ff_mod_mul(&temp1, &temp1, &curve->g.x, &curve->p.m);          // x^3
+    ff_mod_mul(&temp2, &curve->a, &curve->g.x, &curve->p.m);       // ax
+    ff_mod_add(&temp1, &temp1, &temp2, &curve->p.m);               // x^3 + ax
+    ff_mod_add(&temp1, &temp1, &curve->b, &curve->p.m);            // x^3 + ax + b
     
     // Calculate left side: y^2
-    ff_mul(&temp2, &gy, &gy);
-    ff_mod(&temp2, &temp2, &p);
+    ff_mod_mul(&temp2, &curve->g.y, &curve->g.y, &curve->p.m);
     
     // Verify equation
     assert(ff_eq(&temp1, &temp2));
@@ -359,6 +371,756 @@ static void test_point_validation(void) {
     printf("Point validation tests passed!\n");
 }
 
+// Test the P-256 fast reduction against the generic one
+static void test_p256_field(void) {
+    printf("Testing P-256 field arithmetic...\n");
+    const ec_curve_t* curve = ec_curve_p256();
+
+    ff_t x, y, fast, slow;
+
+    // Inputs close to p exercise every correction in the reduction
+    ff_sub(&x, &curve->p.m, &curve->g.x);
+    ff_from_hex(&y, "ffffffff00000001000000000000000000000000fffffffffffffffffffffffe");
+    fp_mul(curve, &fast, &x, &y);
+    ff_mod_mul(&slow, &x, &y, &curve->p.m);
+    assert(ff_eq(&fast, &slow));
+
+    fp_mul(curve, &fast, &curve->g.x, &curve->g.y);
+    ff_mod_mul(&slow, &curve->g.x, &curve->g.y, &curve->p.m);
+    assert(ff_eq(&fast, &slow));
+
+    // x * x^-1 = 1
+    ff_t one;
+    ff_from_u32(&one, 1);
+    fp_inv(curve, &y, &curve->g.x);
+    fp_mul(curve, &fast, &curve->g.x, &y);
+    assert(ff_eq(&fast, &one));
+
+    // sqrt(y^2) = +-y
+    fp_sqr(curve, &x, &curve->g.y);
+    assert(fp_sqrt(curve, &y, &x));
+    fp_sub(curve, &fast, &curve->p.m, &y);
+    assert(ff_eq(&y, &curve->g.y) || ff_eq(&fast, &curve->g.y));
+
+    printf("P-256 field arithmetic tests passed!\n");
+}
+
+// Test every curve descriptor: the reduction picked at init against the
+// generic one, the comb against plain double-and-add and known multiples
+static void test_curves(void) {
+    printf("Testing curve descriptors...\n");
+
+    const ec_params_t* params[] = { &ec_params_p256, &ec_params_secp256k1, &ec_params_toy };
+    static ec_curve_t curves[3];
+    for (int i = 0; i < 3; i++) {
+        ec_curve_t* curve = &curves[i];
+        ec_curve_init(curve, params[i]);
+
+        ff_t x, y, fast, slow, k;
+        ff_sub(&x, &curve->p.m, &curve->g.x);
+        ff_sub(&y, &curve->p.m, &curve->g.y);
+        fp_mul(curve, &fast, &x, &y);
+        ff_mod_mul(&slow, &x, &y, &curve->p.m);
+        assert(ff_eq(&fast, &slow));
+
+        ff_sub(&x, &curve->n.m, &curve->g.x);
+        fn_reduce(curve, &x, &x);
+        fn_mul(curve, &fast, &x, &curve->g.y);
+        ff_mod_mul(&slow, &x, &curve->g.y, &curve->n.m);
+        assert(ff_eq(&fast, &slow));
+
+        assert(ec_is_on_curve(curve, &curve->g));
+
+        ECPoint A, B;
+        for (int j = 0; j < 4; j++) {
+            ec_init_random_k(curve, &k);
+            assert(ec_scalar_mul_base(curve, &A, &k) == ec_scalar_mul(curve, &B, &curve->g, &k));
+            assert(ff_eq(&A.x, &B.x) && ff_eq(&A.y, &B.y));
+        }
+
+        assert(!ec_scalar_mul_base(curve, &A, &curve->n.m));
+    }
+
+    assert(curves[0].a_is_minus_3 && !curves[0].a_is_zero);
+    assert(!curves[1].a_is_minus_3 && curves[1].a_is_zero);
+    assert(!curves[2].a_is_minus_3 && !curves[2].a_is_zero);
+
+    ECPoint R;
+    ff_t k;
+    ff_from_hex(&k, "1234567890abcdef");
+    ec_scalar_mul_base(&curves[1], &R, &k);
+    assert(ff_equals_hex(&R.x, "f973a0b87062c389d125d8199e803b832b6ac6bf7867a4f6cd87506060fc4c58"));
+    assert(ff_equals_hex(&R.y, "4b4a0a3f26c988c54c236b224c48bb605b265949e65c098ecd87a581ca10e25d"));
+
+    // Same as ec_mul(1234, G) on the toy curve in main.c
+    ff_from_u32(&k, 1234);
+    ec_scalar_mul_base(&curves[2], &R, &k);
+    assert(R.x.words[0] == 0xc42 && R.y.words[0] == 0x6ee);
+
+    printf("Curve descriptor tests passed!\n");
+}
+
+// Test simultaneous inversion against one inversion per point, and that the
+// width-4 NAF recodes back to the scalar
+static void test_batch_to_affine(void) {
+    printf("Testing batch affine conversion...\n");
+    const ec_curve_t* curve = ec_curve_p256();
+
+    ECPointJ in[5];
+    ECPoint out[5], expected;
+    ec_to_jacobian(&in[0], &curve->g);
+    in[1] = in[0];
+    ec_double_inplace(curve, &in[1]);
+    ec_set_infinity_j(&in[2]);
+    in[3] = in[1];
+    ec_add_inplace(curve, &in[3], &curve->g);
+    in[4] = in[3];
+    ec_double_inplace(curve, &in[4]);
+    assert(ec_batch_to_affine(curve, out, in, 5) == 1u << 2);
+
+    for (int i = 0; i < 5; i++) {
+        if (i == 2) {
+            assert(!ec_to_affine(curve, &expected, &in[i]));
+            continue;
+        }
+        assert(ec_to_affine(curve, &expected, &in[i]));
+        assert(ff_eq(&out[i].x, &expected.x) && ff_eq(&out[i].y, &expected.y));
+    }
+
+    // sum of digits * 2^i == k, including a scalar whose NAF is one digit longer
+    int8_t digits[EC_WNAF_MAX_DIGITS];
+    ff_t k, sum, term;
+    ff_from_hex(&k, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    for (int round = 0; round < 2; round++) {
+        int len = ec_wnaf(digits, &k);
+        assert(len <= EC_WNAF_MAX_DIGITS);
+        ff_zero(&sum);
+        for (int i = len - 1; i >= 0; i--) {
+            ff_add(&sum, &sum, &sum);
+            assert(digits[i] == 0 || (digits[i] & 1));
+            assert(digits[i] < 8 && digits[i] > -8);
+            ff_from_u32(&term, (uint32_t)(digits[i] < 0 ? -digits[i] : digits[i]));
+            if (digits[i] < 0) {
+                ff_sub(&sum, &sum, &term);
+            } else {
+                ff_add(&sum, &sum, &term);
+            }
+        }
+        assert(ff_eq(&sum, &k));
+        ec_init_random_k(curve, &k);
+    }
+
+    printf("Batch affine conversion tests passed!\n");
+}
+
+// The toy curve order N = 3 * 5 * 11 * 59 has points of order 3 and 5,
+// whose wNAF tables hold multiples at infinity. Every product must match
+// k additions of the point.
+static void test_small_order(void) {
+    printf("Testing small order points...\n");
+
+    static ec_curve_t toy;
+    ec_curve_init(&toy, &ec_params_toy);
+    const uint32_t orders[] = { 3, 5 };
+
+    for (int o = 0; o < 2; o++) {
+        ff_t k, k2;
+        ECPoint P, expected, R;
+        ff_from_u32(&k, TOY_CURVE_N / orders[o]);
+        assert(ec_scalar_mul_base(&toy, &P, &k));
+
+        ECPointJ sum;
+        ec_set_infinity_j(&sum);
+        for (uint32_t i = 0; i < 3 * orders[o]; i++) {
+            ff_from_u32(&k, i);
+            int finite = ec_to_affine(&toy, &expected, &sum);
+            assert(finite == (i % orders[o] != 0));
+
+            assert(ec_scalar_mul(&toy, &R, &P, &k) == finite);
+            assert(!finite || (ff_eq(&R.x, &expected.x) && ff_eq(&R.y, &expected.y)));
+            for (uint32_t mask = 0; mask <= EC_BLIND_ALL; mask++) {
+                assert(ec_scalar_mul_blinded(&toy, &R, &P, &k, mask) == finite);
+                assert(!finite || (ff_eq(&R.x, &expected.x) && ff_eq(&R.y, &expected.y)));
+            }
+
+            // G + i * P, the small order table comes second
+            ECPoint with_g = toy.g;
+            if (finite) {
+                assert(ec_add(&toy, &with_g, &toy.g, &expected));
+            }
+            ff_from_u32(&k2, 1);
+            assert(ec_double_scalar_mul(&toy, &R, &k2, &toy.g, &k, &P));
+            assert(ff_eq(&R.x, &with_g.x) && ff_eq(&R.y, &with_g.y));
+
+            ec_add_inplace(&toy, &sum, &P);
+        }
+    }
+
+    printf("Small order point tests passed!\n");
+}
+
+// Every combination of countermeasures gives the unprotected result
+static void test_blinding(void) {
+    printf("Testing scalar multiplication countermeasures...\n");
+
+    static ec_curve_t toy;
+    ec_curve_init(&toy, &ec_params_toy);
+    const ec_curve_t* curves[] = { ec_curve_p256(), &toy };
+
+    for (int c = 0; c < 2; c++) {
+        const ec_curve_t* curve = curves[c];
+        ff_t k, d;
+        ECPoint P, expected, R;
+        do {
+            ec_init_random_k(curve, &d);
+        } while (!ec_scalar_mul_base(curve, &P, &d));
+        ec_init_random_k(curve, &k);
+        int finite = ec_scalar_mul(curve, &expected, &P, &k);
+
+        for (uint32_t mask = 0; mask <= EC_BLIND_ALL; mask++) {
+            assert(ec_scalar_mul_blinded(curve, &R, &P, &k, mask) == finite);
+            assert(!finite || (ff_eq(&R.x, &expected.x) && ff_eq(&R.y, &expected.y)));
+        }
+
+        // with this seed the first r drawn for the blinding point is 0 on the
+        // toy curve, it must be drawn again instead of leaving Q unset
+        if (curve == &toy && finite) {
+            seedRand(0x1e52);
+            assert(ec_scalar_mul_blinded(curve, &R, &P, &k, EC_BLIND_POINT));
+            assert(ff_eq(&R.x, &expected.x) && ff_eq(&R.y, &expected.y));
+        }
+
+        // the randomized accumulator is the same point
+        ECPointJ J;
+        ec_to_jacobian(&J, &P);
+        ec_randomize_j(curve, &J);
+        ec_to_affine(curve, &R, &J);
+        assert(ff_eq(&R.x, &P.x) && ff_eq(&R.y, &P.y));
+    }
+
+    printf("Scalar multiplication countermeasure tests passed!\n");
+}
+
+// Test SEC1 encoding, decompression and public key validation
+static void test_point_encoding(void) {
+    printf("Testing point encoding...\n");
+    const ec_curve_t* curve = ec_curve_p256();
+
+    uint8_t buffer[EC_SEC1_UNCOMPRESSED_BYTES];
+    ECPoint P;
+
+    assert(ec_encode_point(buffer, &curve->g, 0) == EC_SEC1_UNCOMPRESSED_BYTES);
+    assert(buffer[0] == 0x04);
+    assert(ec_decode_point(curve, &P, buffer, EC_SEC1_UNCOMPRESSED_BYTES));
+    assert(ff_eq(&P.x, &curve->g.x) && ff_eq(&P.y, &curve->g.y));
+
+    // gy is odd
+    assert(ec_encode_point(buffer, &curve->g, 1) == EC_SEC1_COMPRESSED_BYTES);
+    assert(buffer[0] == 0x03);
+    assert(ec_decode_point(curve, &P, buffer, EC_SEC1_COMPRESSED_BYTES));
+    assert(ff_eq(&P.x, &curve->g.x) && ff_eq(&P.y, &curve->g.y));
+
+    // -G decompresses to the other root
+    buffer[0] = 0x02;
+    assert(ec_decode_point(curve, &P, buffer, EC_SEC1_COMPRESSED_BYTES));
+    ff_t neg_gy;
+    ff_sub(&neg_gy, &curve->p.m, &curve->g.y);
+    assert(ff_eq(&P.y, &neg_gy));
+
+    // Off-curve, out of range and malformed keys are rejected
+    ec_encode_point(buffer, &curve->g, 0);
+    buffer[EC_SEC1_UNCOMPRESSED_BYTES - 1] ^= 1;
+    assert(!ec_decode_point(curve, &P, buffer, EC_SEC1_UNCOMPRESSED_BYTES));
+    buffer[0] = 0x05;
+    assert(!ec_decode_point(curve, &P, buffer, EC_SEC1_UNCOMPRESSED_BYTES));
+    assert(!ec_decode_point(curve, &P, buffer, EC_SEC1_COMPRESSED_BYTES - 1));
+
+    ec_init_point(&P, &curve->p.m, &curve->g.y);
+    assert(!ec_validate_public_key(curve, &P));
+    // (0, 0), the old encoding of infinity, is not a point
+    ff_zero(&P.x);
+    ff_zero(&P.y);
+    assert(!ec_validate_public_key(curve, &P));
+
+    printf("Point encoding tests passed!\n");
+}
+
+// Test the key exchange against values computed with crypto.py
+static void test_ecdh(void) {
+    printf("Testing ECDH...\n");
+    const ec_curve_t* curve = ec_curve_p256();
+
+    ff_t d1, d2;
+    ECPoint Q1, Q2;
+    uint8_t s1[FF_BYTES], s2[FF_BYTES];
+
+    ff_from_hex(&d1, "7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534");
+    ff_from_hex(&d2, "c88f01f510d9ac3f70a292daa2316de544e9aab8afe84049c62a9c57862d1433");
+    ec_scalar_mul(curve, &Q1, &curve->g, &d1);
+    ec_scalar_mul(curve, &Q2, &curve->g, &d2);
+    assert(ff_equals_hex(&Q1.x, "ead218590119e8876b29146ff89ca61770c4edbbf97d38ce385ed281d8a6b230"));
+    assert(ff_equals_hex(&Q1.y, "28af61281fd35e2fa7002523acc85a429cb06ee6648325389f59edfce1405141"));
+
+    assert(ecdh_shared_secret(curve, s1, &d1, &Q2));
+    assert(ecdh_shared_secret(curve, s2, &d2, &Q1));
+    assert(memcmp(s1, s2, FF_BYTES) == 0);
+
+    ff_t shared;
+    ff_from_bytes(&shared, s1);
+    assert(ff_equals_hex(&shared, "dc1c6902b068c697c133fe5e61bf4f6a5f84c011fe75a084b49527282e4a8ef3"));
+
+    // Fresh random key pairs agree too
+    ecdh_keygen(curve, &d1, &Q1);
+    ecdh_keygen(curve, &d2, &Q2);
+    assert(ecdh_shared_secret(curve, s1, &d1, &Q2));
+    assert(ecdh_shared_secret(curve, s2, &d2, &Q1));
+    assert(memcmp(s1, s2, FF_BYTES) == 0);
+
+    // An invalid peer key or private key is refused
+    Q2.y.words[0] ^= 1;
+    assert(!ecdh_shared_secret(curve, s1, &d1, &Q2));
+    assert(!ecdh_shared_secret(curve, s1, &curve->n.m, &Q1));
+
+    printf("ECDH tests passed!\n");
+}
+
+// Test SHA-256 and HMAC-SHA256 against FIPS 180-4 and RFC 4231 vectors
+static void test_sha256(void) {
+    printf("Testing SHA-256...\n");
+
+    uint8_t digest[SHA256_DIGEST_BYTES];
+    ff_t value;
+
+    sha256(digest, (const uint8_t*)"abc", 3);
+    ff_from_bytes(&value, digest);
+    assert(ff_equals_hex(&value, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+
+    // Two blocks of padding
+    const char* two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    sha256(digest, (const uint8_t*)two_blocks, strlen(two_blocks));
+    ff_from_bytes(&value, digest);
+    assert(ff_equals_hex(&value, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+
+    hmac_sha256_t mac;
+    const char* data = "what do ya want for nothing?";
+    hmac_sha256_init(&mac, (const uint8_t*)"Jefe", 4);
+    hmac_sha256_update(&mac, (const uint8_t*)data, strlen(data));
+    hmac_sha256_final(&mac, digest);
+    ff_from_bytes(&value, digest);
+    assert(ff_equals_hex(&value, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"));
+
+    printf("SHA-256 tests passed!\n");
+}
+
+// Test ECDSA against the RFC 6979 A.2.5 P-256/SHA-256 vector
+static void test_ecdsa(void) {
+    printf("Testing ECDSA...\n");
+    const ec_curve_t* curve = ec_curve_p256();
+
+    // Barrett reduction mod n agrees with the generic one
+    ff_t x, y, fast, slow;
+    ff_sub(&x, &curve->n.m, &curve->g.x);
+    ff_sub(&y, &curve->n.m, &curve->g.y);
+    fn_mul(curve, &fast, &x, &y);
+    ff_mod_mul(&slow, &x, &y, &curve->n.m);
+    assert(ff_eq(&fast, &slow));
+
+    ff_t one;
+    ff_from_u32(&one, 1);
+    fn_inv(curve, &y, &x);
+    fn_mul(curve, &fast, &x, &y);
+    assert(ff_eq(&fast, &one));
+
+    ff_t priv, k, r, s;
+    ECPoint pub;
+    uint8_t hash[ECDSA_HASH_BYTES];
+
+    ff_from_hex(&priv, "c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    ec_scalar_mul(curve, &pub, &curve->g, &priv);
+    assert(ff_equals_hex(&pub.x, "60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6"));
+    assert(ff_equals_hex(&pub.y, "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299"));
+
+    sha256(hash, (const uint8_t*)"sample", 6);
+
+    ecdsa_nonce_t drbg;
+    ecdsa_nonce_init(curve, &drbg, &priv, hash);
+    ecdsa_nonce_next(curve, &drbg, &k);
+    assert(ff_equals_hex(&k, "a6e3c57dd01abe90086538398355dd4c3b17aa873382b0f24d6129493d8aad60"));
+
+    assert(ecdsa_sign(curve, &r, &s, &priv, hash));
+    assert(ff_equals_hex(&r, "efd48b2aacb6a8fd1140dd9cd45e81d69d2c877b56aaf991c34d0ea84eaf3716"));
+    assert(ff_equals_hex(&s, "f7cb1c942d657c41d436c7a1b6e29f65f3e900dbb9aff4064dc4ab2f843acda8"));
+
+    assert(ecdsa_verify(curve, &r, &s, &pub, hash));
+
+    // Any change to the message or the signature is detected
+    hash[0] ^= 1;
+    assert(!ecdsa_verify(curve, &r, &s, &pub, hash));
+    hash[0] ^= 1;
+    fn_add(curve, &s, &s, &one);
+    assert(!ecdsa_verify(curve, &r, &s, &pub, hash));
+    assert(!ecdsa_verify(curve, &curve->n.m, &s, &pub, hash));
+
+    // Double scalar multiplication matches two single ones
+    ECPoint A, B, sum;
+    ec_double_scalar_mul(curve, &sum, &x, &curve->g, &priv, &pub);
+    ec_scalar_mul(curve, &A, &curve->g, &x);
+    ec_scalar_mul(curve, &B, &pub, &priv);
+    ec_add(curve, &A, &A, &B);
+    assert(ff_eq(&sum.x, &A.x) && ff_eq(&sum.y, &A.y));
+
+    printf("ECDSA tests passed!\n");
+}
+
+// Byte strings in test vectors are written in memory order
+static void bytes_from_hex(uint8_t* out, const char* hex, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned value;
+        sscanf(hex + 2 * i, "%2x", &value);
+        out[i] = (uint8_t)value;
+    }
+}
+
+// Test X25519 against RFC 7748 sections 5.2 and 6.1
+static void test_x25519(void) {
+    printf("Testing X25519...\n");
+
+    uint8_t scalar[X25519_BYTES], u[X25519_BYTES], out[X25519_BYTES], expected[X25519_BYTES];
+
+    bytes_from_hex(scalar, "a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4", X25519_BYTES);
+    bytes_from_hex(u, "e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c", X25519_BYTES);
+    bytes_from_hex(expected, "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552", X25519_BYTES);
+    x25519(out, scalar, u);
+    assert(memcmp(out, expected, X25519_BYTES) == 0);
+
+    // The top bit of u is ignored
+    bytes_from_hex(scalar, "4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d", X25519_BYTES);
+    bytes_from_hex(u, "e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493", X25519_BYTES);
+    bytes_from_hex(expected, "95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957", X25519_BYTES);
+    x25519(out, scalar, u);
+    assert(memcmp(out, expected, X25519_BYTES) == 0);
+
+    uint8_t alice[X25519_BYTES], alice_pub[X25519_BYTES], bob[X25519_BYTES], bob_pub[X25519_BYTES];
+    bytes_from_hex(alice, "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a", X25519_BYTES);
+    bytes_from_hex(bob, "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb", X25519_BYTES);
+    const uint8_t base[X25519_BYTES] = { 9 };
+    x25519(alice_pub, alice, base);
+    x25519(bob_pub, bob, base);
+    bytes_from_hex(expected, "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a", X25519_BYTES);
+    assert(memcmp(alice_pub, expected, X25519_BYTES) == 0);
+    bytes_from_hex(expected, "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f", X25519_BYTES);
+    assert(memcmp(bob_pub, expected, X25519_BYTES) == 0);
+
+    bytes_from_hex(expected, "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742", X25519_BYTES);
+    assert(x25519_shared_secret(out, alice, bob_pub));
+    assert(memcmp(out, expected, X25519_BYTES) == 0);
+    assert(x25519_shared_secret(out, bob, alice_pub));
+    assert(memcmp(out, expected, X25519_BYTES) == 0);
+
+    // A small order point gives the all zero secret and is refused
+    memset(u, 0, sizeof(u));
+    assert(!x25519_shared_secret(out, alice, u));
+
+    printf("X25519 tests passed!\n");
+}
+
+// Both backends agree with themselves through the common interface
+static void test_kex(void) {
+    printf("Testing key exchange interface...\n");
+
+    const kex_t* kexes[] = { &kex_p256, &kex_x25519 };
+    for (size_t i = 0; i < sizeof(kexes) / sizeof(kexes[0]); i++) {
+        const kex_t* kex = kexes[i];
+        uint8_t priv1[KEX_MAX_PRIV_BYTES], pub1[KEX_MAX_PUB_BYTES];
+        uint8_t priv2[KEX_MAX_PRIV_BYTES], pub2[KEX_MAX_PUB_BYTES];
+        uint8_t s1[KEX_MAX_SECRET_BYTES], s2[KEX_MAX_SECRET_BYTES];
+
+        kex->keygen(priv1, pub1);
+        kex->keygen(priv2, pub2);
+        assert(kex->shared_secret(s1, priv1, pub2));
+        assert(kex->shared_secret(s2, priv2, pub1));
+        assert(memcmp(s1, s2, kex->secret_bytes) == 0);
+    }
+
+    printf("Key exchange interface tests passed!\n");
+}
+
+// seedRand replays the sequence of crypto.PRNG(seed)
+static void test_prng_seed(void) {
+    printf("Testing PRNG seeding...\n");
+
+    seedRand(0xbad5eed);
+    assert(nextRand() == 0xde762952);
+    assert(nextRand() == 0x800ce5b7);
+    seedRand(0x1234);
+    assert(nextRand() == 0x183c0dc2);
+
+    printf("PRNG seeding tests passed!\n");
+}
+
+// feed an encoded frame to a fresh decoder, returns the last push status
+static int decode_frame(const uint8_t* encoded, uint32_t len,
+                        uint8_t* type, uint8_t* payload, uint32_t* payload_len) {
+    frame_decoder_t decoder;
+    frame_decoder_init(&decoder);
+    int status = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        status = frame_decoder_push(&decoder, encoded[i], type, payload, payload_len);
+        assert(status == 0 || i == len - 1);
+    }
+    return status;
+}
+
+// UART framing round trips and rejects corrupted frames
+static void test_frame(void) {
+    printf("Testing UART framing...\n");
+
+    // CRC-16/CCITT-FALSE check value
+    assert(frame_crc16((const uint8_t*)"123456789", 9) == 0x29B1);
+
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint8_t decoded[FRAME_MAX_PAYLOAD];
+    uint8_t encoded[FRAME_MAX_ENCODED];
+    uint8_t type;
+    uint32_t len;
+
+    // zeros, runs longer than a COBS block and every length up to the maximum
+    for (uint32_t n = 0; n <= FRAME_MAX_PAYLOAD; n++) {
+        for (uint32_t i = 0; i < n; i++) {
+            payload[i] = (n % 3 == 0) ? (uint8_t)(i + 1) : (uint8_t)(i * 7 % 5);
+        }
+        uint32_t used = frame_encode(encoded, FRAME_DATA, payload, n);
+        assert(used > 0 && used <= FRAME_MAX_ENCODED);
+        assert(encoded[used - 1] == 0);
+        for (uint32_t i = 0; i + 1 < used; i++) {
+            assert(encoded[i] != 0);
+        }
+        assert(decode_frame(encoded, used, &type, decoded, &len) == 1);
+        assert(type == FRAME_DATA && len == n);
+        assert(memcmp(payload, decoded, n) == 0);
+    }
+    assert(frame_encode(encoded, FRAME_DATA, payload, FRAME_MAX_PAYLOAD + 1) == 0);
+
+    // a flipped bit anywhere is caught
+    const char* line = "scalar 00000042";
+    uint32_t used = frame_encode(encoded, FRAME_COMMAND, (const uint8_t*)line, strlen(line));
+    for (uint32_t i = 0; i + 1 < used; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            uint8_t corrupt[FRAME_MAX_ENCODED];
+            memcpy(corrupt, encoded, used);
+            corrupt[i] ^= 1 << bit;
+            if (corrupt[i] == 0) {
+                continue;   // an early delimiter, covered below
+            }
+            assert(decode_frame(corrupt, used, &type, decoded, &len) == -1);
+        }
+    }
+
+    // the decoder resynchronizes on the next delimiter after garbage
+    frame_decoder_t decoder;
+    frame_decoder_init(&decoder);
+    const uint8_t garbage[] = {0x12, 0x34, 0x00};
+    int status = 0;
+    for (uint32_t i = 0; i < sizeof(garbage); i++) {
+        status = frame_decoder_push(&decoder, garbage[i], &type, decoded, &len);
+    }
+    assert(status == -1);
+    for (uint32_t i = 0; i < used; i++) {
+        status = frame_decoder_push(&decoder, encoded[i], &type, decoded, &len);
+    }
+    assert(status == 1 && type == FRAME_COMMAND && len == strlen(line));
+    assert(memcmp(decoded, line, len) == 0);
+
+    // an oversized frame is dropped without overrunning the buffer
+    frame_decoder_init(&decoder);
+    for (uint32_t i = 0; i < 2 * FRAME_MAX_ENCODED; i++) {
+        assert(frame_decoder_push(&decoder, 0x55, &type, decoded, &len) == 0);
+    }
+    assert(frame_decoder_push(&decoder, 0, &type, decoded, &len) == -1);
+
+    printf("UART framing tests passed!\n");
+}
+
+// SPSC ring between the UART interrupt and the main loop
+static void test_ring(void) {
+    printf("Testing UART ring...\n");
+
+    uint8_t storage[16];
+    uint8_t in[40], out[40];
+    for (uint32_t i = 0; i < sizeof(in); i++) {
+        in[i] = (uint8_t)(i * 13 + 1);
+    }
+
+    ring_t ring;
+    ring_init(&ring, storage, sizeof(storage));
+    assert(ring_count(&ring) == 0);
+    assert(ring_read(&ring, out, sizeof(out)) == 0);
+
+    // only what fits is written
+    assert(ring_write(&ring, in, sizeof(in)) == sizeof(storage));
+    assert(ring_count(&ring) == sizeof(storage));
+    assert(ring_write(&ring, in, 1) == 0);
+    assert(ring_read(&ring, out, 5) == 5);
+    assert(memcmp(out, in, 5) == 0);
+
+    // wraps around the storage and keeps the order
+    assert(ring_write(&ring, in + 16, 5) == 5);
+    assert(ring_read(&ring, out, sizeof(out)) == 16);
+    assert(memcmp(out, in + 5, 16) == 0);
+
+    // free running indices crossing 2^32
+    ring.head = ring.tail = 0xFFFFFFF8u;
+    for (uint32_t round = 0; round < 4; round++) {
+        assert(ring_write(&ring, in, 11) == 11);
+        assert(ring_count(&ring) == 11);
+        assert(ring_read(&ring, out, 11) == 11);
+        assert(memcmp(out, in, 11) == 0);
+    }
+    assert(ring.head < 0xFFFFFFF8u);
+
+    // peek returns the contiguous part up to the end of the storage, as
+    // the TX DMA reads it
+    ring_init(&ring, storage, sizeof(storage));
+    ring.head = ring.tail = 12;
+    assert(ring_write(&ring, in, 10) == 10);
+    const uint8_t* chunk;
+    assert(ring_peek(&ring, &chunk) == 4);
+    assert(chunk == storage + 12 && memcmp(chunk, in, 4) == 0);
+    ring_skip(&ring, 4);
+    assert(ring_peek(&ring, &chunk) == 6);
+    assert(chunk == storage && memcmp(chunk, in + 4, 6) == 0);
+    ring_skip(&ring, 6);
+    assert(ring_count(&ring) == 0 && ring_peek(&ring, &chunk) == 0);
+
+    printf("UART ring tests passed!\n");
+}
+
+// bump allocator for the curve scratch, alignment, exhaustion and scoped
+// release
+static void arena_scope_use(arena_t* arena) {
+    ARENA_SCOPE(arena);
+    assert(arena_alloc(arena, 40) != NULL);
+    assert(arena->used == 48);
+}
+
+static void test_arena(void) {
+    printf("Testing scratch arena...\n");
+
+    static uint64_t storage[8];
+    arena_t arena;
+    arena_init(&arena, storage, sizeof(storage));
+
+    // blocks are rounded up to ARENA_ALIGN and follow each other
+    uint8_t* a = (uint8_t*)arena_alloc(&arena, 3);
+    uint8_t* b = (uint8_t*)arena_alloc(&arena, 8);
+    assert(a == (uint8_t*)storage && b == a + ARENA_ALIGN);
+    assert(arena_mark(&arena) == 16);
+
+    // a request that doesn't fit fails without taking anything
+    uint32_t mark = arena_mark(&arena);
+    assert(arena_alloc(&arena, 49) == NULL);
+    assert(arena_alloc(&arena, 0xFFFFFFFFu) == NULL);
+    assert(arena_mark(&arena) == mark);
+    assert(arena_alloc(&arena, 48) != NULL);
+    assert(arena_alloc(&arena, 1) == NULL);
+
+    // reset frees back to the mark and keeps the peak
+    arena_reset(&arena, mark);
+    assert(arena.used == 16 && arena.peak == 64);
+    assert(arena_alloc(&arena, 8) == b + ARENA_ALIGN);
+
+    // a scope releases on exit
+    arena_reset(&arena, 8);
+    arena_scope_use(&arena);
+    assert(arena.used == 8);
+
+    // the curve code leaves the shared scratch empty
+    ec_curve_t curve;
+    ec_curve_init(&curve, &ec_params_p256);
+    assert(scratch_arena.used == 0);
+    ECPoint R;
+    ff_t k;
+    ff_from_u32(&k, 12345);
+    assert(ec_scalar_mul(&curve, &R, &curve.g, &k));
+    assert(scratch_arena.used == 0);
+    assert(scratch_arena.peak > 0 && scratch_arena.peak <= SCRATCH_ARENA_SIZE);
+
+    printf("Scratch arena tests passed!\n");
+}
+
+// Run-to-completion scheduler, the "interrupts" are posts made from inside
+// the tasks and between the runs
+static char sched_log[32];
+static int sched_log_len;
+static int sched_ids[3];
+static int sched_repeats;
+
+static void sched_task_a(void) {
+    sched_log[sched_log_len++] = 'a';
+}
+
+// posts the lower priority c, then the higher priority a
+static void sched_task_b(void) {
+    sched_log[sched_log_len++] = 'b';
+    sched_post(sched_ids[2]);
+    sched_post(sched_ids[0]);
+}
+
+// reposts itself a few times, like a task working through a queue
+static void sched_task_c(void) {
+    sched_log[sched_log_len++] = 'c';
+    if (--sched_repeats > 0) {
+        sched_post(sched_ids[2]);
+    }
+}
+
+static void test_sched(void) {
+    printf("Testing scheduler...\n");
+
+    sched_init();
+    sched_ids[0] = sched_add(sched_task_a);
+    sched_ids[1] = sched_add(sched_task_b);
+    sched_ids[2] = sched_add(sched_task_c);
+    assert(sched_ids[0] == 0 && sched_ids[1] == 1 && sched_ids[2] == 2);
+
+    // nothing posted, nothing runs
+    sched_log_len = 0;
+    assert(sched_pending() == 0);
+    assert(sched_run_pending() == 0);
+
+    // posts coalesce and run in priority order
+    sched_post(sched_ids[2]);
+    sched_post(sched_ids[0]);
+    sched_post(sched_ids[0]);
+    sched_post(7);
+    assert(sched_pending() == 0x5);
+    sched_repeats = 1;
+    assert(sched_run_pending() == 2);
+    assert(sched_log_len == 2 && memcmp(sched_log, "ac", 2) == 0);
+    assert(sched_pending() == 0);
+
+    // a post from a running task preempts lower priorities at the next
+    // pick, a self post runs again until the task stops
+    sched_log_len = 0;
+    sched_repeats = 3;
+    sched_post(sched_ids[1]);
+    assert(sched_run_pending() == 5);
+    assert(sched_log_len == 5 && memcmp(sched_log, "baccc", 5) == 0);
+
+    // ids run out at SCHED_MAX_TASKS
+    sched_init();
+    for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+        assert(sched_add(sched_task_a) == i);
+    }
+    assert(sched_add(sched_task_a) == -1);
+    sched_post(SCHED_MAX_TASKS - 1);
+    assert(sched_pending() == 1u << (SCHED_MAX_TASKS - 1));
+    sched_log_len = 0;
+    assert(sched_run_pending() == 1 && sched_log_len == 1);
+
+    printf("Scheduler tests passed!\n");
+}
+
 int main(void) {
     printf("Starting FF library tests...\n");
     
@@ -379,6 +1141,22 @@ int main(void) {
     test_scalar_multiplication();
     test_random_k();
     test_point_validation();
+    test_p256_field();
+    test_curves();
+    test_batch_to_affine();
+    test_small_order();
+    test_blinding();
+    test_point_encoding();
+    test_ecdh();
+    test_sha256();
+    test_ecdsa();
+    test_x25519();
+    test_kex();
+    test_prng_seed();
+    test_frame();
+    test_ring();
+    test_arena();
+    test_sched();
     
     printf("\nAll elliptic curve tests passed successfully!\n");
     return 0;
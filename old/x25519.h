@@ -0,0 +1,275 @@
+#pragma once
+
+#include <stdint.h>
+#include "prng.h"
+
+// X25519 (RFC 7748) over the field 2^255 - 19.
+//
+// Field elements use ten signed limbs in radix 2^25.5: limb i holds 26 bits
+// for even i and 25 bits for odd i, so every partial product fits the M4's
+// single cycle 32x32 -> 64 multiply-accumulate and the 19 * 2^255 wrap-around
+// folds straight back into the low limbs.
+
+#define X25519_BYTES 32
+#define FE25519_LIMBS 10
+
+typedef struct {
+    int32_t v[FE25519_LIMBS];
+} fe25519_t;
+
+// bit offset of each limb, ceil(25.5 * i)
+static const uint8_t fe25519_offset[FE25519_LIMBS] = { 0, 26, 51, 77, 102, 128, 153, 179, 204, 230 };
+
+static inline int fe25519_width(int i) {
+    return (i & 1) ? 25 : 26;
+}
+
+static inline void fe25519_from_u32(fe25519_t* result, uint32_t value) {
+    result->v[0] = (int32_t)value;
+    for (int i = 1; i < FE25519_LIMBS; i++) {
+        result->v[i] = 0;
+    }
+}
+
+// Load 255 little-endian bits, the top bit is ignored as RFC 7748 requires
+static inline void fe25519_from_bytes(fe25519_t* result, const uint8_t* bytes) {
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        int offset = fe25519_offset[i];
+        int width = fe25519_width(i);
+        uint64_t window = 0;
+        for (int j = 0; j < 5 && offset / 8 + j < X25519_BYTES; j++) {
+            window |= (uint64_t)bytes[offset / 8 + j] << (8 * j);
+        }
+        result->v[i] = (int32_t)((window >> (offset % 8)) & ((UINT64_C(1) << width) - 1));
+    }
+}
+
+// Carry every limb into its neighbour, limb 9 wraps around multiplied by 19
+static inline void fe25519_carry(fe25519_t* result, int64_t* h) {
+    int64_t carry;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < FE25519_LIMBS; i++) {
+            int width = fe25519_width(i);
+            carry = (h[i] + ((int64_t)1 << (width - 1))) >> width;
+            h[i] -= carry * ((int64_t)1 << width);
+            if (i == FE25519_LIMBS - 1) {
+                h[0] += carry * 19;
+            } else {
+                h[i + 1] += carry;
+            }
+        }
+    }
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        result->v[i] = (int32_t)h[i];
+    }
+}
+
+// Store the unique representative in [0, p) as 32 little-endian bytes
+static inline void fe25519_to_bytes(uint8_t* bytes, const fe25519_t* a) {
+    int32_t h[FE25519_LIMBS];
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        h[i] = a->v[i];
+    }
+
+    // q = 1 if h >= p, computed from the carries of h + 19
+    int32_t q = (19 * h[9] + ((int32_t)1 << 24)) >> 25;
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        q = (h[i] + q) >> fe25519_width(i);
+    }
+
+    // h - q * p = h + 19 * q - q * 2^255, the last carry is dropped
+    h[0] += 19 * q;
+    for (int i = 0; i < FE25519_LIMBS - 1; i++) {
+        int width = fe25519_width(i);
+        int32_t carry = h[i] >> width;
+        h[i + 1] += carry;
+        h[i] -= carry * ((int32_t)1 << width);
+    }
+    h[9] &= ((int32_t)1 << 25) - 1;
+
+    for (int i = 0; i < X25519_BYTES; i++) {
+        bytes[i] = 0;
+    }
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        uint64_t limb = (uint64_t)(uint32_t)h[i] << (fe25519_offset[i] % 8);
+        for (int j = 0; j < 5 && fe25519_offset[i] / 8 + j < X25519_BYTES; j++) {
+            bytes[fe25519_offset[i] / 8 + j] |= (uint8_t)(limb >> (8 * j));
+        }
+    }
+}
+
+// Additions and subtractions don't carry, the multiplication accepts the
+// slightly larger limbs they produce
+static inline void fe25519_add(fe25519_t* result, const fe25519_t* a, const fe25519_t* b) {
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        result->v[i] = a->v[i] + b->v[i];
+    }
+}
+
+static inline void fe25519_sub(fe25519_t* result, const fe25519_t* a, const fe25519_t* b) {
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        result->v[i] = a->v[i] - b->v[i];
+    }
+}
+
+// Schoolbook product, 100 signed 32x32 -> 64 multiply-accumulates.
+// A product of two odd limbs is doubled since both sit half a bit low, and
+// products past limb 9 are multiplied by 19 and folded onto limb i + j - 10.
+static inline void fe25519_mul(fe25519_t* result, const fe25519_t* a, const fe25519_t* b) {
+    int32_t a2[FE25519_LIMBS], b19[FE25519_LIMBS];
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        a2[i] = (i & 1) ? 2 * a->v[i] : a->v[i];
+        b19[i] = 19 * b->v[i];
+    }
+
+    int64_t h[FE25519_LIMBS] = {0};
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        for (int j = 0; j < FE25519_LIMBS - i; j++) {
+            int32_t x = (j & 1) ? a2[i] : a->v[i];
+            h[i + j] += (int64_t)x * b->v[j];
+        }
+        for (int j = FE25519_LIMBS - i; j < FE25519_LIMBS; j++) {
+            int32_t x = (j & 1) ? a2[i] : a->v[i];
+            h[i + j - FE25519_LIMBS] += (int64_t)x * b19[j];
+        }
+    }
+
+    fe25519_carry(result, h);
+}
+
+static inline void fe25519_sqr(fe25519_t* result, const fe25519_t* a) {
+    fe25519_mul(result, a, a);
+}
+
+static inline void fe25519_mul_small(fe25519_t* result, const fe25519_t* a, int32_t k) {
+    int64_t h[FE25519_LIMBS];
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        h[i] = (int64_t)a->v[i] * k;
+    }
+    fe25519_carry(result, h);
+}
+
+static inline void fe25519_sqr_n(fe25519_t* result, const fe25519_t* a, int times) {
+    fe25519_sqr(result, a);
+    for (int i = 1; i < times; i++) {
+        fe25519_sqr(result, result);
+    }
+}
+
+// a^(p - 2) with the usual 254 squarings and 11 multiplications chain
+static inline void fe25519_inv(fe25519_t* result, const fe25519_t* a) {
+    fe25519_t z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+    fe25519_sqr(&z2, a);                        // 2
+    fe25519_sqr_n(&t, &z2, 2);                  // 8
+    fe25519_mul(&z9, &t, a);                    // 9
+    fe25519_mul(&z11, &z9, &z2);                // 11
+    fe25519_sqr(&t, &z11);                      // 22
+    fe25519_mul(&z2_5_0, &t, &z9);              // 2^5 - 1
+    fe25519_sqr_n(&t, &z2_5_0, 5);
+    fe25519_mul(&z2_10_0, &t, &z2_5_0);         // 2^10 - 1
+    fe25519_sqr_n(&t, &z2_10_0, 10);
+    fe25519_mul(&z2_20_0, &t, &z2_10_0);        // 2^20 - 1
+    fe25519_sqr_n(&t, &z2_20_0, 20);
+    fe25519_mul(&t, &t, &z2_20_0);              // 2^40 - 1
+    fe25519_sqr_n(&t, &t, 10);
+    fe25519_mul(&z2_50_0, &t, &z2_10_0);        // 2^50 - 1
+    fe25519_sqr_n(&t, &z2_50_0, 50);
+    fe25519_mul(&z2_100_0, &t, &z2_50_0);       // 2^100 - 1
+    fe25519_sqr_n(&t, &z2_100_0, 100);
+    fe25519_mul(&t, &t, &z2_100_0);             // 2^200 - 1
+    fe25519_sqr_n(&t, &t, 50);
+    fe25519_mul(&t, &t, &z2_50_0);              // 2^250 - 1
+    fe25519_sqr_n(&t, &t, 5);
+    fe25519_mul(result, &t, &z11);              // 2^255 - 21
+}
+
+// Swap a and b when swap is 1 without a data dependent branch
+static inline void fe25519_cswap(fe25519_t* a, fe25519_t* b, uint32_t swap) {
+    int32_t mask = -(int32_t)swap;
+    for (int i = 0; i < FE25519_LIMBS; i++) {
+        int32_t x = mask & (a->v[i] ^ b->v[i]);
+        a->v[i] ^= x;
+        b->v[i] ^= x;
+    }
+}
+
+// X-only Montgomery ladder, RFC 7748 section 5
+static inline void x25519(uint8_t* out, const uint8_t* scalar, const uint8_t* point) {
+    uint8_t k[X25519_BYTES];
+    for (int i = 0; i < X25519_BYTES; i++) {
+        k[i] = scalar[i];
+    }
+    k[0] &= 248;
+    k[31] &= 127;
+    k[31] |= 64;
+
+    fe25519_t x1, x2, z2, x3, z3;
+    fe25519_t a, aa, b, bb, e, c, d, da, cb;
+
+    fe25519_from_bytes(&x1, point);
+    fe25519_from_u32(&x2, 1);
+    fe25519_from_u32(&z2, 0);
+    x3 = x1;
+    fe25519_from_u32(&z3, 1);
+
+    uint32_t swap = 0;
+    for (int t = 254; t >= 0; t--) {
+        uint32_t k_t = (k[t / 8] >> (t % 8)) & 1;
+        swap ^= k_t;
+        fe25519_cswap(&x2, &x3, swap);
+        fe25519_cswap(&z2, &z3, swap);
+        swap = k_t;
+
+        fe25519_add(&a, &x2, &z2);
+        fe25519_sqr(&aa, &a);
+        fe25519_sub(&b, &x2, &z2);
+        fe25519_sqr(&bb, &b);
+        fe25519_sub(&e, &aa, &bb);
+        fe25519_add(&c, &x3, &z3);
+        fe25519_sub(&d, &x3, &z3);
+        fe25519_mul(&da, &d, &a);
+        fe25519_mul(&cb, &c, &b);
+
+        fe25519_add(&x3, &da, &cb);
+        fe25519_sqr(&x3, &x3);
+        fe25519_sub(&z3, &da, &cb);
+        fe25519_sqr(&z3, &z3);
+        fe25519_mul(&z3, &z3, &x1);
+
+        fe25519_mul(&x2, &aa, &bb);
+        fe25519_mul_small(&z2, &e, 121665);
+        fe25519_add(&z2, &z2, &aa);
+        fe25519_mul(&z2, &z2, &e);
+    }
+    fe25519_cswap(&x2, &x3, swap);
+    fe25519_cswap(&z2, &z3, swap);
+
+    fe25519_inv(&z2, &z2);
+    fe25519_mul(&x2, &x2, &z2);
+    fe25519_to_bytes(out, &x2);
+}
+
+// Generate a key pair, pub = X25519(priv, 9)
+static inline void x25519_keygen(uint8_t* priv, uint8_t* pub) {
+    static const uint8_t base[X25519_BYTES] = { 9 };
+    for (int i = 0; i < X25519_BYTES; i += 4) {
+        uint32_t r = nextRand();
+        priv[i + 0] = (uint8_t)r;
+        priv[i + 1] = (uint8_t)(r >> 8);
+        priv[i + 2] = (uint8_t)(r >> 16);
+        priv[i + 3] = (uint8_t)(r >> 24);
+    }
+    x25519(pub, priv, base);
+}
+
+// Shared secret, returns 0 for the all zero output of a small order peer
+// point as RFC 7748 section 6.1 recommends
+static inline int x25519_shared_secret(uint8_t* secret, const uint8_t* priv, const uint8_t* peer_pub) {
+    x25519(secret, priv, peer_pub);
+    uint8_t acc = 0;
+    for (int i = 0; i < X25519_BYTES; i++) {
+        acc |= secret[i];
+    }
+    return acc != 0;
+}
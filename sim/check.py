@@ -0,0 +1,82 @@
+"""
+Protocol regression run of the host simulation build.
+
+Drives firmware_sim over a pipe in text and in binary mode from the same
+PRNG seed and checks that the secrets replay with crypto.PRNG, that every
+point is secret * G, that both modes print the same results and that the
+trigger log holds one window per doubling:
+
+    python3 sim/check.py build-sim/firmware_sim
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from crypto import PRNG  # noqa: E402
+from toy_dlog import ToyDlog, load_params  # noqa: E402
+from uart_frame import FRAME_COMMAND, encode_frame, read_responses, values  # noqa: E402
+
+SEED = 0x0123456789ABCDEF
+COUNT = 3
+
+
+def run(sim: str, data: bytes, trigger: str = None) -> bytes:
+    env = dict(os.environ)
+    env.pop("SIM_UART", None)
+    if trigger:
+        env["SIM_TRIGGER"] = trigger
+    return subprocess.run([sim], input=data, stdout=subprocess.PIPE, env=env,
+                          timeout=60, check=True).stdout
+
+
+def text_values(output: bytes) -> list:
+    return [int(v, 16) for v in re.findall(rb"^:\x00?([0-9A-Fa-f]{8})\r?$", output, re.MULTILINE)]
+
+
+def main(sim: str) -> int:
+    p = load_params()["P"]
+    dlog = ToyDlog()
+    prng = PRNG(SEED)
+    secrets = [prng.next_rand() % p for _ in range(COUNT)]
+
+    with tempfile.TemporaryDirectory() as tmp:
+        trigger = str(Path(tmp) / "trigger.txt")
+        text = text_values(run(sim, f"seed {SEED:016x}\r".encode() + b"\r" * COUNT, trigger))
+        edges = [line.split() for line in Path(trigger).read_text().splitlines()
+                 if not line.startswith("#")]
+
+    assert text[0] == 1, "seed rejected"
+    results = [tuple(text[i:i + 3]) for i in range(1, len(text), 3)]
+    assert len(results) == COUNT, f"{len(results)} results for {COUNT} lines"
+    for secret, (k, x, y) in zip(secrets, results):
+        assert k == secret, f"secret {k:#x}, expected {secret:#x}"
+        assert dlog.check(k, x, y), f"({x:#x}, {y:#x}) is not {k:#x} * G"
+
+    rising = sum(1 for _, pin, level in edges if pin == "15" and level == "1")
+    assert rising == 32 * COUNT, f"{rising} trigger windows for {COUNT} multiplications"
+
+    binary = run(sim, f"seed {SEED:016x}\rbinary\r".encode()
+                 + b"".join(encode_frame(FRAME_COMMAND) for _ in range(COUNT))
+                 + encode_frame(FRAME_COMMAND, b"text"))
+    # the first frame follows the text reply without a delimiter
+    reply = b"binary\r\n:\x0000000001"
+    responses = read_responses(binary[binary.index(reply) + len(reply):])
+    assert len(responses) == COUNT + 1 and None not in responses, responses
+    assert [tuple(values(r)) for r in responses[:COUNT]] == results, "binary results differ"
+    assert values(responses[COUNT]) == [1]
+
+    print(f"ok, {COUNT} multiplications in text and binary mode")
+    return 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(2)
+    sys.exit(main(sys.argv[1]))
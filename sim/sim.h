@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Hooks of the host simulation build (SIM_BUILD=1), see sim/CMakeLists.txt.
+/// Only firmware headers that touch hardware the simulator can't map as
+/// plain memory include this.
+
+/// Timestamp for cyccnt_read and the trigger log: user space instructions
+/// retired when perf_event_open allows it, nanoseconds otherwise
+uint64_t sim_counter(void);
+
+/// Logs a level change of a GPIOD pin (LD3_Pin, LD6_Pin) to the file named
+/// by SIM_TRIGGER as "<counter> <pin number> <level>", level 2 is a marker
+void sim_pin(uint32_t pin, int level);
+
+/// Appends a register write of the toy field arithmetic to the operand trace
+/// named by SIM_OPERANDS and returns value, see sim_hal.c for the records
+uint32_t sim_operand(uint32_t value);
+
+/// Waits for UART input and delivers it, the body of WFI (sim_uart_io.c)
+void sim_uart_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
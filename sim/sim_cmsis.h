@@ -0,0 +1,72 @@
+#pragma once
+
+/// Host replacement for CMSIS/Include/cmsis_gcc.h, force included before
+/// everything else so the real one (Cortex-M inline assembly) sees its
+/// include guard and stays empty. The compiler attributes keep their GCC
+/// meaning, the instructions become calls into the simulator.
+
+#define __CMSIS_GCC_H
+
+#include <stdint.h>
+
+#define __ASM __asm
+#define __INLINE inline
+#define __STATIC_INLINE static inline
+#define __STATIC_FORCEINLINE __attribute__((always_inline)) static inline
+#define __NO_RETURN __attribute__((__noreturn__))
+#define __USED __attribute__((used))
+#define __WEAK __attribute__((weak))
+#define __PACKED __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x) __attribute__((aligned(x)))
+#define __RESTRICT __restrict
+#define __COMPILER_BARRIER() __asm volatile("" ::: "memory")
+
+#define __NOP() do {} while (0)
+#define __DSB() __COMPILER_BARRIER()
+#define __ISB() __COMPILER_BARRIER()
+#define __DMB() __COMPILER_BARRIER()
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Sleep until the simulated UART has input, delivering it like the
+/// reception interrupt would
+void sim_wfi(void);
+
+/// PRIMASK, only recorded: simulated interrupts run inside sim_wfi
+extern uint32_t sim_primask;
+
+#ifdef __cplusplus
+}
+#endif
+
+#define __WFI() sim_wfi()
+#define __WFE() sim_wfi()
+#define __SEV() do {} while (0)
+
+__STATIC_FORCEINLINE void __enable_irq(void) {
+  sim_primask = 0;
+}
+
+__STATIC_FORCEINLINE void __disable_irq(void) {
+  sim_primask = 1;
+}
+
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void) {
+  return sim_primask;
+}
+
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t primask) {
+  sim_primask = primask;
+}
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value) {
+  return __builtin_bswap32(value);
+}
+
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value) {
+  return value == 0 ? 32 : (uint8_t)__builtin_clz(value);
+}
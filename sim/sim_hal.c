@@ -0,0 +1,189 @@
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "sim.h"
+
+// The HAL calls of main.c and clock.c, the instructions of sim_cmsis.h and
+// the hooks of sim.h. Register accesses made directly by the firmware
+// (RCC clock enables, DWT, ITM, the flash ACR) land in plain memory mapped
+// at the peripheral addresses, so they read back what was written and
+// nothing polls a ready flag.
+
+uint32_t SystemCoreClock = 16000000;
+uint32_t sim_primask = 0;
+
+static FILE* trigger_log = NULL;
+static FILE* operand_trace = NULL;
+static int perf_fd = -1;
+static struct timespec start_time;
+
+static void map_region(uintptr_t base, size_t size) {
+  void* p = mmap((void*)base, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if (p != (void*)base) {
+    fprintf(stderr, "can't map the peripherals at %#lx\n", (unsigned long)base);
+    exit(1);
+  }
+}
+
+// before main: the APB and AHB1 peripherals and the Cortex-M system area,
+// then the counter and the trigger log
+__attribute__((constructor)) static void sim_init(void) {
+  map_region(PERIPH_BASE, 0x80000);
+  map_region(0xE0000000UL, 0x100000);
+
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  perf_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  const char* path = getenv("SIM_TRIGGER");
+  if (path != NULL) {
+    trigger_log = fopen(path, "w");
+    if (trigger_log == NULL) {
+      perror(path);
+      exit(1);
+    }
+    fprintf(trigger_log, "# %s pin level\n", perf_fd >= 0 ? "instructions" : "ns");
+  }
+
+  path = getenv("SIM_OPERANDS");
+  if (path != NULL) {
+    operand_trace = fopen(path, "wb");
+    if (operand_trace == NULL) {
+      perror(path);
+      exit(1);
+    }
+  }
+}
+
+// operand trace records, two little endian words: SIM_RECORD_OPERAND and the
+// value written, or SIM_RECORD_PIN and pin number << 8 | level
+#define SIM_RECORD_OPERAND 0u
+#define SIM_RECORD_PIN 1u
+
+static void operand_record(uint32_t kind, uint32_t value) {
+  uint32_t record[2] = {kind, value};
+  fwrite(record, sizeof(record), 1, operand_trace);
+}
+
+static uint64_t elapsed_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)(now.tv_sec - start_time.tv_sec) * 1000000000u +
+         (uint64_t)now.tv_nsec - (uint64_t)start_time.tv_nsec;
+}
+
+uint64_t sim_counter(void) {
+  uint64_t count;
+  if (perf_fd >= 0 && read(perf_fd, &count, sizeof(count)) == sizeof(count)) {
+    return count;
+  }
+  return elapsed_ns();
+}
+
+void sim_pin(uint32_t pin, int level) {
+  if (trigger_log != NULL) {
+    fprintf(trigger_log, "%llu %d %d\n", (unsigned long long)sim_counter(),
+            __builtin_ctz(pin), level);
+  }
+  if (operand_trace != NULL) {
+    operand_record(SIM_RECORD_PIN, (uint32_t)__builtin_ctz(pin) << 8 | (uint32_t)level);
+  }
+}
+
+uint32_t sim_operand(uint32_t value) {
+  if (operand_trace != NULL) {
+    operand_record(SIM_RECORD_OPERAND, value);
+  }
+  return value;
+}
+
+void sim_wfi(void) {
+  if (trigger_log != NULL) {
+    fflush(trigger_log);
+  }
+  if (operand_trace != NULL) {
+    fflush(operand_trace);
+  }
+  sim_uart_poll();
+}
+
+HAL_StatusTypeDef HAL_Init(void) {
+  return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void) {
+  return (uint32_t)(elapsed_ns() / 1000000u);
+}
+
+void HAL_Delay(uint32_t Delay) {
+  struct timespec t = {Delay / 1000, (long)(Delay % 1000) * 1000000L};
+  nanosleep(&t, NULL);
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) {
+  (void)IRQn;
+  (void)PreemptPriority;
+  (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+  (void)IRQn;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init) {
+  (void)GPIOx;
+  (void)GPIO_Init;
+}
+
+// the LEDs besides the trigger pins, not logged
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+  (void)GPIOx;
+  (void)GPIO_Pin;
+  (void)PinState;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin) {
+  (void)GPIOx;
+  (void)GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart) {
+  huart->gState = HAL_UART_STATE_READY;
+  huart->RxState = HAL_UART_STATE_READY;
+  return HAL_OK;
+}
+
+// the PLL settings of the last HAL_RCC_OscConfig, for SystemCoreClock
+static RCC_PLLInitTypeDef pll;
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef* RCC_OscInitStruct) {
+  if (RCC_OscInitStruct->PLL.PLLState == RCC_PLL_ON) {
+    pll = RCC_OscInitStruct->PLL;
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef* RCC_ClkInitStruct, uint32_t FLatency) {
+  (void)FLatency;
+  if (RCC_ClkInitStruct->SYSCLKSource == RCC_SYSCLKSOURCE_PLLCLK && pll.PLLM != 0) {
+    uint32_t input = pll.PLLSource == RCC_PLLSOURCE_HSE ? HSE_VALUE : HSI_VALUE;
+    SystemCoreClock = input / pll.PLLM * pll.PLLN / pll.PLLP;
+  } else {
+    SystemCoreClock = HSI_VALUE;
+  }
+  return HAL_OK;
+}
@@ -0,0 +1,175 @@
+#include "uart_io.h"
+#include "ring.h"
+#include "sim.h"
+
+// after the device header, termios.h defines CR1 and others as macros
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+// uart_io.h on a pipe (stdin and stdout) or a pty, in place of the DMA
+// driver. Input is only taken in sim_uart_poll, called from WFI, so like on
+// the board bytes wait while a command runs. Output is written at once
+// unless a trigger hold queues it.
+
+static int uart_in = STDIN_FILENO;
+static int uart_out = STDOUT_FILENO;
+static int uart_pty = 0;
+
+static uint8_t rx_storage[UART_RX_RING_SIZE];
+static ring_t rx_ring;
+static uint32_t rx_dropped;
+static void (*rx_callback)(void);
+
+static uint8_t tx_storage[UART_TX_RING_SIZE];
+static ring_t tx_ring;
+static uint32_t tx_hold_depth;
+static int tx_trigger_hold;
+static uint32_t tx_dropped;
+
+static void write_all(const uint8_t* data, uint32_t len) {
+  while (len > 0) {
+    ssize_t n = write(uart_out, data, len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      // the reader is gone
+      exit(0);
+    }
+    data += n;
+    len -= (uint32_t)n;
+  }
+}
+
+static void tx_drain(void) {
+  const uint8_t* chunk;
+  uint32_t len;
+  while ((len = ring_peek(&tx_ring, &chunk)) > 0) {
+    write_all(chunk, len);
+    ring_skip(&tx_ring, len);
+  }
+}
+
+static int tx_held(void) {
+  return tx_trigger_hold && tx_hold_depth > 0;
+}
+
+// SIM_UART=pty opens a pseudo terminal and prints the name of its slave on
+// stderr for tio or uart_frame.Device. The slave stays open here too, so
+// a client may disconnect and come back without a hangup.
+void uart_io_start(UART_HandleTypeDef* huart) {
+  (void)huart;
+  ring_init(&rx_ring, rx_storage, sizeof(rx_storage));
+  ring_init(&tx_ring, tx_storage, sizeof(tx_storage));
+  tx_hold_depth = 0;
+
+  const char* mode = getenv("SIM_UART");
+  if (mode == NULL || strcmp(mode, "pty") != 0) {
+    return;
+  }
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    perror("posix_openpt");
+    exit(1);
+  }
+  int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  struct termios tio;
+  if (slave < 0 || tcgetattr(slave, &tio) != 0) {
+    perror(ptsname(master));
+    exit(1);
+  }
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  uart_in = uart_out = master;
+  uart_pty = 1;
+  fprintf(stderr, "UART on %s\n", ptsname(master));
+}
+
+void uart_io_update_baud(void) {
+}
+
+// blocks until input arrives, moves it to the ring and runs the reception
+// callback. The end of a piped input ends the simulation.
+void sim_uart_poll(void) {
+  uint8_t buffer[UART_RX_DMA_SIZE];
+  struct pollfd pfd = {uart_in, POLLIN, 0};
+  if (poll(&pfd, 1, -1) < 0) {
+    return;
+  }
+  ssize_t n = read(uart_in, buffer, sizeof(buffer));
+  if (n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN && !uart_pty)) {
+    tx_drain();
+    exit(0);
+  }
+  if (n <= 0) {
+    return;
+  }
+  rx_dropped += (uint32_t)n - ring_write(&rx_ring, buffer, (uint32_t)n);
+  if (rx_callback != NULL) {
+    rx_callback();
+  }
+}
+
+uint32_t uart_io_read(uint8_t* data, uint32_t len) {
+  return ring_read(&rx_ring, data, len);
+}
+
+void uart_io_on_receive(void (*callback)(void)) {
+  rx_callback = callback;
+}
+
+uint32_t uart_io_rx_dropped(void) {
+  return rx_dropped;
+}
+
+void uart_io_write(const uint8_t* data, uint32_t len) {
+  if (!tx_held()) {
+    tx_drain();
+    write_all(data, len);
+    return;
+  }
+  tx_dropped += len - ring_write(&tx_ring, data, len);
+}
+
+uint32_t uart_io_try_write(const uint8_t* data, uint32_t len) {
+  if (!tx_held()) {
+    uart_io_write(data, len);
+    return len;
+  }
+  return ring_write(&tx_ring, data, len);
+}
+
+void uart_io_flush(void) {
+  if (!tx_held()) {
+    tx_drain();
+  }
+}
+
+uint32_t uart_io_tx_dropped(void) {
+  return tx_dropped;
+}
+
+void uart_io_set_trigger_hold(int enable) {
+  tx_trigger_hold = enable;
+  uart_io_flush();
+}
+
+int uart_io_trigger_hold(void) {
+  return tx_trigger_hold;
+}
+
+void uart_io_hold_begin(void) {
+  tx_hold_depth++;
+}
+
+void uart_io_hold_end(void) {
+  if (tx_hold_depth > 0 && --tx_hold_depth == 0) {
+    uart_io_flush();
+  }
+}
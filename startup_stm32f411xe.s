@@ -35,6 +35,13 @@
 /* start address for the initialization values of the .data section. 
 defined in linker script */
 .word  _sidata
+/* start address for the initialization values of the .ramfunc section.
+defined in linker script */
+.word  _siramfunc
+/* start address for the .ramfunc section. defined in linker script */
+.word  _sramfunc
+/* end address for the .ramfunc section. defined in linker script */
+.word  _eramfunc
 /* start address for the .data section. defined in linker script */  
 .word  _sdata
 /* end address for the .data section. defined in linker script */
@@ -79,6 +86,23 @@ LoopCopyDataInit:
   adds r4, r0, r3
   cmp r4, r1
   bcc CopyDataInit
+
+/* Copy the RAMFUNC code and RAMDATA tables from flash to SRAM */
+  ldr r0, =_sramfunc
+  ldr r1, =_eramfunc
+  ldr r2, =_siramfunc
+  movs r3, #0
+  b LoopCopyRamFunc
+
+CopyRamFunc:
+  ldr r4, [r2, r3]
+  str r4, [r0, r3]
+  adds r3, r3, #4
+
+LoopCopyRamFunc:
+  adds r4, r0, r3
+  cmp r4, r1
+  bcc CopyRamFunc
   
 /* Zero fill the bss segment. */
   ldr r2, =_sbss
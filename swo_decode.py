@@ -0,0 +1,161 @@
+"""
+Decoder for the ITM event log in Core/Inc/itm_log.h.
+
+Build the firmware with -DITM_LOG=ON and record the SWO pin through the
+ST-LINK with openocd, the TPIU in UART mode without formatter and the trace
+clock equal to the core clock (16 MHz unless a clock profile is selected):
+
+    sudo openocd -f tcl/interface/stlink.cfg -f tcl/target/stm32f4x.cfg \\
+        -c "init" \\
+        -c "stm32f4x.tpiu configure -protocol uart -formatter 0 -traceclk 16000000 -pin-freq 2000000 -output trace.swo" \\
+        -c "stm32f4x.tpiu enable" -c "itm port 1 on"
+
+then decode the recorded byte stream:
+
+    python3 swo_decode.py trace.swo
+"""
+
+import struct
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Iterable, Iterator, List, Optional, Tuple
+
+ITM_LOG_PORT = 1
+
+EVENTS = {1: "op_start", 2: "op_end", 3: "step", 4: "mark"}
+OPS = {1: "toy_mul", 2: "batch"}
+
+
+@dataclass
+class Packet:
+    kind: str           # "sync", "overflow", "swit", "hw", "lts", "gts", "ext"
+    port: int = 0       # stimulus port of swit and hw packets
+    value: int = 0      # payload, or the timestamp delta of lts packets
+    size: int = 0       # payload bytes of swit and hw packets
+
+
+@dataclass
+class Event:
+    time: Optional[int]  # sum of the timestamp deltas in core cycles, None before the first
+    event: int
+    arg: int
+
+    @property
+    def name(self) -> str:
+        return EVENTS.get(self.event, f"event{self.event}")
+
+    def __str__(self) -> str:
+        time = "?" if self.time is None else str(self.time)
+        arg = OPS.get(self.arg, str(self.arg)) if self.event in (1, 2) else str(self.arg)
+        return f"{time:>12} {self.name} {arg}"
+
+
+def _continued(data: bytes, i: int) -> Tuple[int, int]:
+    """Value of up to 4 continuation bytes (7 bits each, LSB first) from i"""
+    value = shift = 0
+    while i < len(data):
+        byte = data[i]
+        i += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            break
+    return value, i
+
+
+def parse_packets(data: bytes) -> Iterator[Packet]:
+    """ITM packets of a raw SWO stream, a truncated last packet is dropped"""
+    i = 0
+    while i < len(data):
+        header = data[i]
+        i += 1
+        if header == 0x00:
+            # sync is at least 47 zero bits then a one, skip the run
+            while i < len(data) and data[i] == 0x00:
+                i += 1
+            if i < len(data) and data[i] == 0x80:
+                i += 1
+                yield Packet("sync")
+        elif header == 0x70:
+            yield Packet("overflow")
+        elif header & 0x03:
+            size = {1: 1, 2: 2, 3: 4}[header & 0x03]
+            if i + size > len(data):
+                return
+            value = int.from_bytes(data[i:i + size], "little")
+            i += size
+            yield Packet("hw" if header & 0x04 else "swit", header >> 3, value, size)
+        elif header & 0x0F == 0x00:
+            if header & 0x80:
+                value, i = _continued(data, i)
+                yield Packet("lts", value=value)
+            else:
+                yield Packet("lts", value=(header >> 4) & 0x07)
+        elif header in (0x94, 0xB4):
+            value, i = _continued(data, i)
+            yield Packet("gts", value=value)
+        elif header & 0x0B == 0x08:
+            value = 0
+            if header & 0x80:
+                value, i = _continued(data, i)
+            yield Packet("ext", value=value)
+        # anything else is reserved and skipped
+
+
+def events(packets: Iterable[Packet], port: int = ITM_LOG_PORT) -> List[Event]:
+    """Events written to the log port. A local timestamp follows the packets
+    it times and holds the delta since the previous one."""
+    result: List[Event] = []
+    pending: List[Event] = []
+    time: Optional[int] = None
+    for packet in packets:
+        if packet.kind == "swit" and packet.port == port and packet.size == 4:
+            event = Event(None, packet.value >> 24, packet.value & 0xFFFFFF)
+            pending.append(event)
+            result.append(event)
+        elif packet.kind == "lts":
+            time = packet.value if time is None else time + packet.value
+            for event in pending:
+                event.time = time
+            pending.clear()
+        elif packet.kind == "overflow":
+            result.append(Event(time, 0, 0))
+    return result
+
+
+def encode_event(event: int, arg: int, delta: Optional[int] = None, port: int = ITM_LOG_PORT) -> bytes:
+    """Bytes the ITM emits for one 32-bit stimulus write and its timestamp,
+    to build test streams"""
+    out = bytes([(port << 3) | 0x03]) + struct.pack("<I", (event << 24) | (arg & 0xFFFFFF))
+    if delta is None:
+        return out
+    if 0 < delta < 7:
+        return out + bytes([delta << 4])
+    body = bytearray()
+    while True:
+        body.append(delta & 0x7F)
+        delta >>= 7
+        if not delta:
+            break
+        body[-1] |= 0x80
+    return out + bytes([0xC0]) + bytes(body)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        # self check on a synthetic stream: sync, events, timestamps, overflow
+        stream = (b"\x00" * 5 + b"\x80"
+                  + encode_event(1, 1, 1000)
+                  + encode_event(3, 0, 5)
+                  + encode_event(3, 1, 300)
+                  + b"\x70"
+                  + encode_event(2, 1, 20000))
+        found = events(parse_packets(stream))
+        assert [(e.time, e.event, e.arg) for e in found] == [
+            (1000, 1, 1), (1005, 3, 0), (1305, 3, 1), (1305, 0, 0), (21305, 2, 1)]
+        print("ok")
+        sys.exit(0)
+
+    for event in events(parse_packets(Path(sys.argv[1]).read_bytes())):
+        print("overflow" if event.event == 0 else event)
@@ -0,0 +1,87 @@
+"""
+Discrete logarithm maps for the toy curve.
+
+The toy curve group has only N = 9735 elements, so every k * G fits in a
+dictionary and a captured output point can be mapped back to its scalar in
+O(1). Run on a tio log of empty-line multiplications, which print the
+secret, x and y as ':XXXXXXXX' lines, to check every result:
+
+    python3 toy_dlog.py capture.log
+"""
+
+import re
+import sys
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+from crypto import EllipticCurve, Point
+
+TOY_CURVE_H = Path(__file__).parent / "Core" / "Inc" / "toy_curve.h"
+
+# Printed by the firmware for both coordinates of the point at infinity
+INFINITY = 0xFFFFFFFF
+
+
+def load_params(header: Path = TOY_CURVE_H) -> Dict[str, int]:
+    """Read the TOY_CURVE_* defines shared with the firmware"""
+    params = {}
+    for match in re.finditer(r"#define TOY_CURVE_(\w+) (\d+)", header.read_text()):
+        params[match.group(1)] = int(match.group(2))
+    return params
+
+
+class ToyDlog:
+    """point -> k and x -> [k, N - k] maps of every multiple of G"""
+
+    def __init__(self, params: Optional[Dict[str, int]] = None):
+        params = params or load_params()
+        self.n = params["N"]
+        self.curve = EllipticCurve(params["A"], params["B"], params["P"])
+        self.g = Point(params["GX"], params["GY"])
+
+        self.point_to_k: Dict[Tuple[int, int], int] = {}
+        self.x_to_k: Dict[int, List[int]] = {}
+        R = self.g
+        for k in range(1, self.n):
+            self.point_to_k[(R.x, R.y)] = k
+            self.x_to_k.setdefault(R.x, []).append(k)
+            R = self.curve.add(R, self.g)
+        assert R.is_infinity(), "TOY_CURVE_N is not the order of G"
+
+    def log(self, x: int, y: int) -> Optional[int]:
+        """k in [0, N) with k * G = (x, y), None if it is not a multiple of G"""
+        if x == INFINITY and y == INFINITY:
+            return 0
+        return self.point_to_k.get((x, y))
+
+    def log_x(self, x: int) -> List[int]:
+        """Both scalars whose multiple of G has this x coordinate"""
+        return self.x_to_k.get(x, [])
+
+    def check(self, k: int, x: int, y: int) -> bool:
+        """Whether (x, y) = k * G"""
+        found = self.log(x, y)
+        return found is not None and found == k % self.n
+
+
+def parse_log(text: str) -> List[Tuple[int, int, int]]:
+    """Group the ':XXXXXXXX' lines of a capture into (secret, x, y), the
+    firmware sends the NUL terminating its ':' prefix as well"""
+    values = [int(v, 16) for v in re.findall(r"^:\x00?([0-9A-Fa-f]{8})\s*$", text, re.MULTILINE)]
+    return [tuple(values[i:i + 3]) for i in range(0, len(values) - 2, 3)]
+
+
+if __name__ == "__main__":
+    dlog = ToyDlog()
+    if len(sys.argv) < 2:
+        print(f"{len(dlog.point_to_k) + 1} points, 1234 * G -> {dlog.log(0xc42, 0x6ee)}")
+        sys.exit(0)
+
+    results = parse_log(Path(sys.argv[1]).read_text(errors="replace"))
+    bad = 0
+    for secret, x, y in results:
+        if not dlog.check(secret, x, y):
+            bad += 1
+            print(f"mismatch: secret {secret:#x}, point ({x:#x}, {y:#x}) is k = {dlog.log(x, y)}")
+    print(f"{len(results) - bad}/{len(results)} results match")
+    sys.exit(1 if bad else 0)
@@ -0,0 +1,191 @@
+"""
+Host side of the binary UART framing in Core/Inc/frame.h.
+
+Each frame is type (1 byte), payload length (2 bytes, little-endian), the
+payload and a CRC-16/CCITT-FALSE of everything before it (2 bytes,
+little-endian), COBS encoded and terminated by a 0x00 byte. After the `binary`
+command the board only speaks frames: send a FRAME_COMMAND holding a command
+line (empty for a random toy multiplication) and collect FRAME_DATA frames
+until the FRAME_END, their payloads joined are the response values packed raw
+(4 big-endian bytes for each value the text mode prints as 8 hex digits).
+
+Decode a recorded stream, e.g. a `tio --log` of a binary session:
+
+    python3 uart_frame.py capture.bin
+"""
+
+import struct
+import sys
+import time
+from pathlib import Path
+from typing import Iterable, Iterator, List, Optional, Tuple
+
+FRAME_COMMAND = 0x01
+FRAME_DATA = 0x02
+FRAME_END = 0x03
+FRAME_UNKNOWN = 0x04
+
+FRAME_MAX_PAYLOAD = 256
+
+
+def crc16(data: bytes) -> int:
+    """CRC-16/CCITT-FALSE, same as frame_crc16"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for byte in data:
+        if byte:
+            out.append(byte)
+            code += 1
+        if not byte or code == 0xFF:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+    out[code_at] = code
+    return bytes(out)
+
+
+def cobs_decode(data: bytes) -> Optional[bytes]:
+    """None if the encoding is malformed"""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(frame_type: int, payload: bytes = b"") -> bytes:
+    """COBS encoded frame including the 0x00 delimiter"""
+    if len(payload) > FRAME_MAX_PAYLOAD:
+        raise ValueError(f"payload longer than {FRAME_MAX_PAYLOAD} bytes")
+    raw = struct.pack("<BH", frame_type, len(payload)) + payload
+    raw += struct.pack("<H", crc16(raw))
+    return cobs_encode(raw) + b"\x00"
+
+
+def decode_frame(encoded: bytes) -> Optional[Tuple[int, bytes]]:
+    """(type, payload) of one frame without its delimiter, None if corrupt"""
+    raw = cobs_decode(encoded)
+    if raw is None or len(raw) < 5:
+        return None
+    frame_type, length = struct.unpack_from("<BH", raw)
+    if length > FRAME_MAX_PAYLOAD or len(raw) != 5 + length:
+        return None
+    if struct.unpack_from("<H", raw, len(raw) - 2)[0] != crc16(raw[:-2]):
+        return None
+    return frame_type, raw[3:-2]
+
+
+class FrameDecoder:
+    """Incremental decoder, feed it bytes as they arrive"""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.errors = 0
+
+    def feed(self, data: bytes) -> Iterator[Tuple[int, bytes]]:
+        for byte in data:
+            if byte:
+                self.buffer.append(byte)
+                continue
+            if not self.buffer:
+                continue
+            frame = decode_frame(bytes(self.buffer))
+            self.buffer.clear()
+            if frame is None:
+                self.errors += 1
+            else:
+                yield frame
+
+
+def responses(frames: Iterable[Tuple[int, bytes]]) -> Iterator[Optional[bytes]]:
+    """Join FRAME_DATA payloads up to each FRAME_END, None for FRAME_UNKNOWN"""
+    pending = bytearray()
+    for frame_type, payload in frames:
+        if frame_type == FRAME_DATA:
+            pending += payload
+        elif frame_type == FRAME_END:
+            yield bytes(pending + payload)
+            pending.clear()
+        elif frame_type == FRAME_UNKNOWN:
+            pending.clear()
+            yield None
+
+
+def values(response: bytes) -> List[int]:
+    """Split a response made only of 32-bit values"""
+    return [v for (v,) in struct.iter_unpack(">I", response[:len(response) // 4 * 4])]
+
+
+def read_responses(data: bytes) -> List[Optional[bytes]]:
+    """Every response in a recorded stream, the text before the first frame
+    (the `binary` command and its reply) fails the CRC check and is skipped"""
+    return list(responses(FrameDecoder().feed(data)))
+
+
+class Device:
+    """Binary mode session over a serial port (needs pyserial)"""
+
+    def __init__(self, port: str, baudrate: int = 115200, timeout: float = 10.0):
+        import serial
+        self.serial = serial.Serial(port, baudrate, timeout=timeout)
+        self.decoder = FrameDecoder()
+        # in text mode this switches and the delimiter is an empty frame, in
+        # binary mode it is one corrupt frame answered with FRAME_UNKNOWN
+        self.serial.write(b"binary\r\x00")
+        time.sleep(0.2)
+        self.serial.reset_input_buffer()
+
+    def command(self, line: bytes = b"") -> Optional[bytes]:
+        """Run a command, its raw response or None if it was not understood"""
+        self.serial.write(encode_frame(FRAME_COMMAND, line))
+        pending = bytearray()
+        while True:
+            chunk = self.serial.read_until(b"\x00")
+            if not chunk.endswith(b"\x00"):
+                raise TimeoutError("no response from the board")
+            for frame_type, payload in self.decoder.feed(chunk):
+                if frame_type == FRAME_DATA:
+                    pending += payload
+                elif frame_type == FRAME_END:
+                    return bytes(pending + payload)
+                elif frame_type == FRAME_UNKNOWN:
+                    return None
+
+    def close(self):
+        self.command(b"text")
+        self.serial.close()
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        # round trip self check
+        for n in (0, 1, 253, 254, 255, FRAME_MAX_PAYLOAD):
+            payload = bytes(i % 3 for i in range(n))
+            frame = encode_frame(FRAME_DATA, payload)
+            assert b"\x00" not in frame[:-1]
+            assert decode_frame(frame[:-1]) == (FRAME_DATA, payload)
+        assert crc16(b"123456789") == 0x29B1
+        print("ok")
+        sys.exit(0)
+
+    decoder = FrameDecoder()
+    for response in responses(decoder.feed(Path(sys.argv[1]).read_bytes())):
+        print("?" if response is None else " ".join(f"{v:08X}" for v in values(response)))
+    if decoder.errors:
+        print(f"{decoder.errors} corrupt frames")